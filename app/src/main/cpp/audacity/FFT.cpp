@@ -4,7 +4,11 @@
  */
 
 #include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <mutex>
 #include "FFT.h"
+#include "../debug/TrafficCounter.h"
 
 FFT::FFT(int fftLen) : length(fftLen), length4(fftLen * 4) {
     /*
@@ -15,7 +19,6 @@ FFT::FFT(int fftLen) : length(fftLen), length4(fftLen * 4) {
     points = fftLen / 2;
     sinTable = new float[2*points];
     bitReversed = new int[points];
-    buffer = new float[length];
 
     for(int i = 0; i < points; i++) {
         int temp = 0;
@@ -29,12 +32,39 @@ FFT::FFT(int fftLen) : length(fftLen), length4(fftLen * 4) {
         sinTable[bitReversed[i]] = (float) -sin(2*PI*i/(2*points));
         sinTable[bitReversed[i]+1] = (float) -cos(2*PI*i/(2*points));
     }
+
+    // Twiddles for the real-even transform
+    evenSin = new float[points];
+    evenCos = new float[points];
+    for(int i = 0; i < points; i++) {
+        evenSin[i] = (float) sin(PI*i/fftLen);
+        evenCos[i] = (float) cos(PI*i/fftLen);
+    }
 }
 
 FFT::~FFT() {
     delete[] sinTable;
     delete[] bitReversed;
-    delete[] buffer;
+    delete[] evenSin;
+    delete[] evenCos;
+}
+
+/*
+ * Get a plan for a given length that's shared by every user in the process
+ * Plans are read-only once built, so any number of threads can apply them at once.
+ * A plan is freed when its last user releases it.
+ */
+std::shared_ptr<FFT> FFT::getShared(int fftLen) {
+    static std::mutex lock;
+    static std::map<int, std::weak_ptr<FFT>> plans;
+
+    std::lock_guard<std::mutex> guard(lock);
+    std::shared_ptr<FFT> plan = plans[fftLen].lock();
+    if (!plan) {
+        plan = std::make_shared<FFT>(fftLen);
+        plans[fftLen] = plan;
+    }
+    return plan;
 }
 
 void FFT::hannWindowFunc(bool extraSample, float *in) const {
@@ -52,13 +82,32 @@ void FFT::hannWindowFunc(bool extraSample, float *in) const {
         in[NumSamples] *= 0;
 }
 
-void FFT::apply(float *RealIn, float *RealOut, float *ImagOut) const {
+/*
+ * The FFT tables are read-only after construction, so one instance can be shared between
+ * threads as long as each thread passes its own processing buffer (length floats)
+ */
+void FFT::apply(float *RealIn, float *RealOut, float *ImagOut, float *buffer) const {
+
+    applyHalf(RealIn, RealOut, ImagOut, buffer);
+
+    // Fill in the upper half using symmetry properties
+    for(int i = length / 2 + 1; i < length; i++) {
+        RealOut[i] =  RealOut[length-i];
+        ImagOut[i] = -ImagOut[length-i];
+    }
+}
+
+/*
+ * Same as apply, but only writes bins 0 to length / 2 since the upper half of a real
+ * FFT is just the mirrored conjugate
+ */
+void FFT::applyHalf(float *RealIn, float *RealOut, float *ImagOut, float *buffer) const {
 
     // Copy the data into the processing buffer
     if (length >= 0) memcpy(buffer, RealIn, length4);
 
     // Perform the FFT
-    apply();
+    apply(buffer);
 
     // Copy the data into the real and imaginary outputs
     for (int i = 1; i<(length / 2); i++) {
@@ -69,14 +118,9 @@ void FFT::apply(float *RealIn, float *RealOut, float *ImagOut) const {
     RealOut[0] = buffer[0];
     RealOut[length / 2] = buffer[1];
     ImagOut[0] = ImagOut[length / 2] = 0;
-    // Fill in the upper half using symmetry properties
-    for(int i = length / 2 + 1; i < length; i++) {
-        RealOut[i] =  RealOut[length-i];
-        ImagOut[i] = -ImagOut[length-i];
-    }
 }
 
-void FFT::apply() const {
+void FFT::apply(float *buffer) const {
     int A, B;
     int sptr;
     int endptr1, endptr2;
@@ -152,3 +196,194 @@ void FFT::apply() const {
     buffer[0] += buffer[1];
     buffer[1] = v1;
 }
+
+/*
+ * Batched real FFT over several windows stored in structure-of-arrays layout:
+ * sample j of window k is at buffer[j * batch + k]. Each butterfly is applied to every
+ * window at once, so the inner loops run across windows and vectorize.
+ *
+ * buffer holds the real input (length * batch floats) and is overwritten. The half
+ * spectrum (bins 0 to length / 2) is written in the same layout to RealOut and ImagOut,
+ * which each need (length / 2 + 1) * batch floats.
+ */
+void FFT::applyBatch(float *buffer, float *RealOut, float *ImagOut, int batch) const {
+
+    // Perform the FFTs
+    switch (batch) {
+        case 1: transformBatch<1>(buffer, batch); break;
+        case 2: transformBatch<2>(buffer, batch); break;
+        case 4: transformBatch<4>(buffer, batch); break;
+        case 8: transformBatch<8>(buffer, batch); break;
+        default: transformBatch<0>(buffer, batch); break;
+    }
+
+    // Copy the data into the real and imaginary outputs (two loads and two stores per bin)
+    int half = length / 2;
+    COUNT_TRAFFIC(4 * sizeof(float) * (half + 1) * batch);
+    for (int i = 1; i < half; i++) {
+        const float *src = buffer + bitReversed[i] * batch;
+        float *re = RealOut + i * batch;
+        float *im = ImagOut + i * batch;
+        for (int k = 0; k < batch; k++) {
+            re[k] = src[k];
+            im[k] = src[batch + k];
+        }
+    }
+    // Handle the (real-only) DC and Fs/2 bins
+    for (int k = 0; k < batch; k++) {
+        RealOut[k] = buffer[k];
+        RealOut[half * batch + k] = buffer[batch + k];
+        ImagOut[k] = ImagOut[half * batch + k] = 0;
+    }
+}
+
+/*
+ * Real-even transform: the DFT of a real, symmetric sequence of 2 * length points, which is
+ * itself real and symmetric. This is a DCT-I of length + 1 points, computed with a single
+ * real FFT of this size (after cosft1 from Numerical Recipes) instead of a full transform
+ * of twice the size.
+ *
+ * buffer holds the first length + 1 points of each sequence in structure-of-arrays layout
+ * ((length + 1) * batch floats) and is overwritten. Out receives the first length + 1 bins
+ * in the same layout. RealOut and ImagOut are work areas of (length / 2 + 1) * batch floats.
+ */
+void FFT::applyRealEven(float *buffer, float *Out, float *RealOut, float *ImagOut, int batch) const {
+    int n = length;
+    int half = length / 2;
+
+    // Fold the sequence so that one real FFT gives the even bins directly and the odd
+    // bins as a running sum, which starts in row 1 of the output
+    float *sum = Out + batch;
+    float *first = buffer;
+    float *last = buffer + n * batch;
+    COUNT_TRAFFIC(6 * sizeof(float) * half * batch);
+    for (int k = 0; k < batch; k++) {
+        sum[k] = 0.5f * (first[k] - last[k]);
+        first[k] = 0.5f * (first[k] + last[k]);
+    }
+    for (int m = 1; m < half; m++) {
+        float *a = buffer + m * batch;
+        float *b = buffer + (n - m) * batch;
+        float s = evenSin[m], c = evenCos[m];
+        for (int k = 0; k < batch; k++) {
+            float y1 = 0.5f * (a[k] + b[k]);
+            float y2 = a[k] - b[k];
+            a[k] = y1 - s * y2;
+            b[k] = y1 + s * y2;
+            sum[k] += c * y2;
+        }
+    }
+
+    applyBatch(buffer, RealOut, ImagOut, batch);
+
+    // The DC imaginary part is always zero, so it holds the running sum from here on
+    float *running = ImagOut;
+    COUNT_TRAFFIC(6 * sizeof(float) * half * batch);
+    for (int k = 0; k < batch; k++) {
+        running[k] = sum[k];
+        Out[k] = 2 * RealOut[k];
+        Out[batch + k] = 2 * sum[k];
+        Out[n * batch + k] = 2 * RealOut[half * batch + k];
+    }
+    for (int i = 1; i < half; i++) {
+        const float *re = RealOut + i * batch;
+        const float *im = ImagOut + i * batch;
+        float *even = Out + 2 * i * batch;
+        float *odd = even + batch;
+        for (int k = 0; k < batch; k++) {
+            even[k] = 2 * re[k];
+            running[k] -= im[k];
+            odd[k] = 2 * running[k];
+        }
+    }
+}
+
+/*
+ * Same steps as apply(buffer), with every array access widened to the batch of windows
+ * K is the batch size if known at compile time, otherwise 0 to use the batch parameter
+ */
+template<int K>
+void FFT::transformBatch(float *buffer, int batch) const {
+    const int n = K > 0 ? K : batch;
+    int A, B;
+    int sptr;
+    int endptr1, endptr2;
+    int br1, br2;
+    float sin, cos;
+
+    int ButterfliesPerGroup = points / 2;
+
+    endptr1 = points * 2;
+
+    while (ButterfliesPerGroup > 0) {
+        // Each butterfly loads and stores two complex values of every window
+        COUNT_TRAFFIC(8 * sizeof(float) * (points / 2) * n);
+        A = 0;
+        B = ButterfliesPerGroup * 2;
+        sptr = 0;
+
+        while (A < endptr1) {
+            sin = sinTable[sptr];
+            cos = sinTable[sptr+1];
+            endptr2 = B;
+            while (A < endptr2) {
+                float *a = buffer + A * n;
+                float *b = buffer + B * n;
+                for (int k = 0; k < n; k++) {
+                    float v1 = b[k] * cos + b[n + k] * sin;
+                    float v2 = b[k] * sin - b[n + k] * cos;
+                    float ar = a[k], ai = a[n + k];
+                    b[k] = ar + v1;
+                    a[k] = ar - v1;
+                    b[n + k] = ai - v2;
+                    a[n + k] = ai + v2;
+                }
+                A += 2;
+                B += 2;
+            }
+            A = B;
+            B += ButterfliesPerGroup * 2;
+            sptr += 2;
+        }
+        ButterfliesPerGroup >>= 1;
+    }
+    /* Massage output to get the output for a real input sequence. */
+    br1 = 1;
+    br2 = points - 1;
+
+    while(br1 < br2) {
+        sin = sinTable[bitReversed[br1]];
+        cos = sinTable[bitReversed[br1] + 1];
+        float *a = buffer + bitReversed[br1] * n;
+        float *b = buffer + bitReversed[br2] * n;
+        for (int k = 0; k < n; k++) {
+            float HRminus = a[k] - b[k];
+            float HRplus = HRminus + (b[k] * 2);
+            float HIminus = a[n + k] - b[n + k];
+            float HIplus = HIminus + (b[n + k] * 2);
+            float v1 = (sin*HRminus - cos*HIplus);
+            float v2 = (cos*HRminus + sin*HIplus);
+            a[k] = (HRplus + v1) * 0.5f;
+            b[k] = a[k] - v1;
+            a[n + k] = (HIminus + v2) * 0.5f;
+            b[n + k] = a[n + k] - HIminus;
+        }
+
+        br1++;
+        br2--;
+    }
+    COUNT_TRAFFIC(8 * sizeof(float) * (br1 - 1) * n);
+    /* Handle the center bin (just need a conjugate) */
+    float *center = buffer + (bitReversed[br1] + 1) * n;
+    for (int k = 0; k < n; k++)
+        center[k] = -center[k];
+    COUNT_TRAFFIC(2 * sizeof(float) * n);
+    /* Handle DC and Fs/2 bins separately */
+    /* Put the Fs/2 value into the imaginary part of the DC bin */
+    for (int k = 0; k < n; k++) {
+        float v1 = buffer[k] - buffer[n + k];
+        buffer[k] += buffer[n + k];
+        buffer[n + k] = v1;
+    }
+    COUNT_TRAFFIC(4 * sizeof(float) * n);
+}
@@ -33,6 +33,7 @@
 #define __AUDACITY_FFT_H__
 
 #include <map>
+#include <memory>
 #include "../PI.h"
 
 class FFT {
@@ -41,21 +42,34 @@ public:
     FFT(int fftLen);
     ~FFT();
 
-    void apply(float *RealIn, float *RealOut, float *ImagOut) const;
-    void apply() const;
+    void apply(float *RealIn, float *RealOut, float *ImagOut, float *buffer) const;
+    void applyHalf(float *RealIn, float *RealOut, float *ImagOut, float *buffer) const;
+    void apply(float *buffer) const;
+    void applyBatch(float *buffer, float *RealOut, float *ImagOut, int batch) const;
+    void applyRealEven(float *buffer, float *Out, float *RealOut, float *ImagOut, int batch) const;
     void hannWindowFunc(bool extraSample, float *in) const;
 
+    static std::shared_ptr<FFT> getShared(int fftLen);
+
     const int length;
 
 private:
 
+    template<int K> void transformBatch(float *buffer, int batch) const;
+
     const int length4;
     int points;
     float *sinTable;
     int *bitReversed;
-    float *buffer;
+    float *evenSin;
+    float *evenCos;
 
 };
 
+/**
+ * Largest batch the batched FFT has a specialized (fully unrolled) version for
+ */
+static const int MAX_FFT_BATCH = 8;
+
 
 #endif
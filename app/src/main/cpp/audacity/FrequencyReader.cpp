@@ -3,38 +3,203 @@
  * Adapted from https://github.com/audacity/audacity/blob/master/libraries/lib-math/Spectrum.cpp
  */
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include "FrequencyReader.h"
+#include "SpectrumKernels.h"
+#include "../debug/TrafficCounter.h"
 
-FrequencyReader::FrequencyReader(int sampleRate, float minAmplitude)
-: sampleRate(sampleRate), minAmplitude(minAmplitude) {
+FrequencyReader::FrequencyReader(int sampleRate, float minAmplitude, std::shared_ptr<WorkerPool> pool)
+: sampleRate(sampleRate), minAmplitude(minAmplitude), pool(pool) {
 
+    int fullSize;
     if (sampleRate == 44100) // Most common sample rate - save some calc time
-        windowSize = 4096;
+        fullSize = 4096;
     else
-        windowSize = std::max(256, (int) round(pow(2.0, floor(log2(sampleRate / 20.0) + 0.5))));
-    windowSizeH = windowSize / 2;
-    windowSize2 = windowSize * 2;
-    windowSize4 = windowSize * 4;
-
-    fft = std::make_shared<FFT>(windowSize);
-    processed = new float[windowSize];
-    in = new float[windowSize];
-    out = new float[windowSize];
-    out2 = new float[windowSize];
-    freq = new float[windowSizeH];
-    freqa = new float[windowSizeH];
+        fullSize = std::max(256, (int) round(pow(2.0, floor(log2(sampleRate / 20.0) + 0.5))));
+
+    // Build every smaller window size adaptive sizing can switch to, and the longer window
+    // bass notes are analyzed again with, so switching never allocates or plans on the
+    // analysis thread. Plans are shared with every other reader using the same window size.
+    for (int size = std::min(ADAPTIVE_MIN_WINDOW, fullSize); size <= fullSize; size *= 2)
+        plans.push_back(buildPlan(size));
+    bassPlan = buildPlan(fullSize * 2);
+    int batchFloats = (bassPlan.size + 2) * bassPlan.maxBatch;
+    for (const WindowPlan &plan : plans)
+        batchFloats = std::max(batchFloats, (plan.size + 2) * plan.maxBatch);
+    selectWindow(plans.back());
+
+    freqa = new float[bassPlan.size / 2];
+    power = new float[bassPlan.size / 2 + 1];
+    powerFloor = 0;
+
+    // Each worker gets its own buffers so windows can be processed in parallel, sized for
+    // whichever window size needs the most
+    scratch.resize(pool->getNumWorkers());
+    for (Scratch &s : scratch) {
+        s.processed = new float[batchFloats / 2];
+        s.batch = new float[batchFloats];
+        s.re = new float[batchFloats / 2];
+        s.im = new float[batchFloats / 2];
+    }
 }
 
 FrequencyReader::~FrequencyReader() {
-    delete[] processed;
-    delete[] in;
-    delete[] out;
-    delete[] out2;
-    delete[] freq;
+    for (Scratch &s : scratch) {
+        delete[] s.processed;
+        delete[] s.batch;
+        delete[] s.re;
+        delete[] s.im;
+    }
+    for (WindowPlan &plan : plans)
+        delete[] plan.window;
+    delete[] bassPlan.window;
     delete[] freqa;
+    delete[] power;
+}
+
+/**
+ * Detect the fundamental frequency of a range of audio
+ * @param wav Wav data
+ * @param channel Channel to read
+ * @param startFrame First frame to scan
+ * @param scanFrames Number of frames to scan (0 for 0.2 seconds)
+ * @param confidence Set to the strength of the detected period (0 to 1) if not null
+ * @return Frequency in hertz or 0 if nothing was detected
+ */
+float FrequencyReader::getFrequency(WavData *wav, int channel, int startFrame, int scanFrames,
+                                    float *confidence) {
+
+    // Default to 0.2 seconds
+    if (scanFrames <= 0)
+        scanFrames = wav->numFrames / 5;
+
+    // A smaller window analyzes as many windows as the full one would, taken from the end
+    // of the scan so the result reflects the newest input
+    int originalStart = startFrame, originalScan = scanFrames;
+    const WindowPlan &plan = adaptiveWindow();
+    selectWindow(plan);
+    getNextScan(wav->numFrames, startFrame, scanFrames);
+
+    float strength;
+    float frequency = detectFrequency(wav, channel, startFrame, scanFrames, &strength);
+
+    // A weak result, or a period longer than half the window, means the pitch left the
+    // smaller window's range, so analyze this hop again with the full window
+    if (plan.size < plans.back().size &&
+        (strength < ADAPTIVE_MIN_CONFIDENCE || frequency * plan.size < 2 * sampleRate)) {
+        selectWindow(plans.back());
+        frequency = detectFrequency(wav, channel, originalStart, originalScan, &strength);
+    }
+
+    // Near the full window's longest lag, neither the lag nor the harmonic peaks (which
+    // overlap below HPS_RESOLVED_BIN) are exact, so the fused detector analyzes bass notes
+    // again with a window twice as long when the scan holds one
+    if (detector == FUSED && frequency > 0 && originalScan >= bassPlan.size &&
+        frequency * plans.back().size < HPS_RESOLVED_BIN * sampleRate) {
+        selectWindow(bassPlan);
+        float bassStrength;
+        float bassFrequency = detectFrequency(wav, channel, originalStart, originalScan,
+                                              &bassStrength);
+        if (bassFrequency > 0) {
+            frequency = bassFrequency;
+            strength = bassStrength;
+        }
+    }
+
+    if (confidence != nullptr)
+        *confidence = strength;
+
+    // Size the next window from this pitch, or go back to the full window once it's lost
+    if (adaptive)
+        trackedFrequency = strength >= ADAPTIVE_MIN_CONFIDENCE ? frequency : 0;
+    return frequency;
+}
+
+/**
+ * Get the frames and window size the next analysis starts with, so callers can check the
+ * input levels of just those windows before preparing the input
+ * @param numFrames Number of frames in the input
+ * @param startFrame First frame to scan, set to the first frame analyzed
+ * @param scanFrames Number of frames to scan, set to the number of frames analyzed
+ * @return Window size in frames
+ */
+int FrequencyReader::getNextScan(int numFrames, int &startFrame, int &scanFrames) const {
+    const WindowPlan &plan = adaptiveWindow();
+    if (plan.size < plans.back().size && startFrame < numFrames) {
+        int windows = std::max(1, (int) round(scanFrames / plans.back().size));
+        int end = std::min(startFrame + scanFrames, numFrames - 1);
+        scanFrames = std::min(windows * plan.size, end - std::max(0, startFrame));
+        startFrame = end - scanFrames;
+    }
+    return plan.size;
+}
+
+/**
+ * Pick the window size for the next analysis
+ * @return Smallest window holding ADAPTIVE_MIN_PERIODS periods of the tracked pitch, or the
+ *         full window when adaptive sizing is off or no pitch is tracked
+ */
+const FrequencyReader::WindowPlan &FrequencyReader::adaptiveWindow() const {
+    if (!adaptive || trackedFrequency <= 0)
+        return plans.back();
+    float span = ADAPTIVE_MIN_PERIODS * sampleRate / trackedFrequency;
+    for (const WindowPlan &plan : plans) {
+        if (plan.size >= span)
+            return plan;
+    }
+    return plans.back();
+}
+
+/**
+ * Build the FFT plans and Hann window for a window size
+ * @param size Window size in frames (a power of two)
+ * @return Plan, whose window is freed with the reader
+ */
+FrequencyReader::WindowPlan FrequencyReader::buildPlan(int size) {
+    WindowPlan plan;
+    plan.size = size;
+    plan.fft = FFT::getShared(size);
+    plan.evenFft = FFT::getShared(size / 2);
+
+    // Precompute the Hann window
+    plan.window = new float[size];
+    std::fill(plan.window, plan.window + size, 1.0f);
+    plan.fft->hannWindowFunc(true, plan.window);
+
+    // Batch as many windows as fit in about 64KB per FFT buffer
+    plan.maxBatch = std::max(1, std::min(MAX_FFT_BATCH, 16384 / size));
+    return plan;
+}
+
+/**
+ * Switch the transforms and buffers over to a window size
+ * @param plan Prebuilt plan for the size
+ */
+void FrequencyReader::selectWindow(const WindowPlan &plan) {
+    windowSize = plan.size;
+    windowSizeH = windowSize / 2;
+    windowSize2 = windowSize * 2;
+    windowSize4 = windowSize * 4;
+    fft = plan.fft;
+    evenFft = plan.evenFft;
+    window = plan.window;
+    maxBatch = plan.maxBatch;
 }
 
-float FrequencyReader::getFrequency(WavData *wav, int channel, int startFrame, int scanFrames) {
+/**
+ * Detect the fundamental frequency with the selected window size
+ * @param wav Wav data
+ * @param channel Channel to read
+ * @param startFrame First frame to scan
+ * @param scanFrames Number of frames to scan
+ * @param confidence Set to the strength of the detected period (0 to 1)
+ * @return Frequency in hertz or 0 if nothing was detected
+ */
+float FrequencyReader::detectFrequency(WavData *wav, int channel, int startFrame, int scanFrames,
+                                       float *confidence) {
+    *confidence = 0;
     if (startFrame >= wav->numFrames)
         return 0;
 
@@ -43,141 +208,469 @@ float FrequencyReader::getFrequency(WavData *wav, int channel, int startFrame, i
     // To detect single notes, analysis period should be about 0.2 seconds.
     // windowSize must be a power of 2.
 
-    // Default to 0.2 seconds
-    if (scanFrames <= 0)
-        scanFrames = wav->numFrames / 5;
-
     // Number of windows based on scan time (4 by default)
     int numWindows = std::max(1, (int) round(scanFrames / windowSize));
     //int numWindows = Math.max(1, (int) Math.round(rate / (5.0f * windowSize)));
 
     startFrame = std::max(0, startFrame);
 
-    memset(freq, 0, windowSize2);
-    memset(freqa, 0, windowSize2);
-
     int srcPos = startFrame;
-    int windowsUsed = 0;
-    for(int i = 0; i < numWindows && srcPos + windowSize < wav->numFrames; i++) {
+    int windows = 0;
+    for(; windows < numWindows && srcPos + windowSize < wav->numFrames; windows++) {
 
         // Strict amplitude filtering
         // If any of the windows are too quiet then return zero for the entire scan
         // This prevents annoying frequency spikes from showing up in the results
+        // All windows are checked up front so no spectrum work is wasted
         if (wav->getPeakAmplitude(srcPos, windowSize) < minAmplitude)
             return 0;
+        srcPos += windowSize;
+    }
+
+    if (windows < 1)
+        return 0;
 
-        // Compute FFT spectrum
-        if (computeSpectrum(wav, channel, srcPos, windowSize, freq, true)) {
-            for (int j = 0; j < windowSizeH; j++)
-                freqa[j] += freq[j];
-            windowsUsed++;
+    // The harmonic product detector only needs the power spectrum of each window
+    bool autoCorrelation = detector != HARMONIC_PRODUCT;
+    bool harmonics = detector != AUTOCORRELATION;
+
+    if (spectra.size() < (size_t) windows * windowSizeH)
+        spectra.resize(windows * windowSizeH);
+    if (energies.size() < (size_t) windows)
+        energies.resize(windows);
+    if (harmonics && powers.size() < (size_t) windows * (windowSizeH + 1))
+        powers.resize(windows * (windowSizeH + 1));
+
+    // Split the windows into batches for the batched FFT, but keep enough batches
+    // to give every worker something to do
+    int workers = pool->getNumWorkers();
+    int batchSize = std::min(maxBatch, (windows + workers - 1) / workers);
+    int numBatches = (windows + batchSize - 1) / batchSize;
+
+    // Compute the FFT spectrum of each window in parallel
+    pool->parallelFor(numBatches, [&](int b, int worker) {
+        Scratch &s = scratch[worker];
+        int first = b * batchSize;
+        int count = std::min(batchSize, windows - first);
+        int starts[MAX_FFT_BATCH];
+        float *targets[MAX_FFT_BATCH];
+        float *windowPowers[MAX_FFT_BATCH];
+        for (int k = 0; k < count; k++) {
+            starts[k] = startFrame + (first + k) * windowSize;
+            targets[k] = s.processed + k * windowSizeH;
+            if (harmonics)
+                windowPowers[k] = powers.data() + (first + k) * (windowSizeH + 1);
+        }
+        // Every window has its own target, so they're assigned rather than cleared and summed
+        transformWindows(wav, channel, starts, count, autoCorrelation ? targets : nullptr, false,
+                         s, harmonics ? windowPowers : nullptr);
+        if (!autoCorrelation)
+            return;
+        for (int k = 0; k < count; k++)
+            finishSpectrum(targets[k], spectra.data() + (first + k) * windowSizeH, 1, true,
+                           energies.data() + first + k);
+    });
+
+    if (harmonics) {
+        // Sum the power spectra in window order too
+        std::copy(powers.data(), powers.data() + windowSizeH + 1, power);
+        COUNT_TRAFFIC(2 * sizeof(float) * (windowSizeH + 1));
+        for (int i = 1; i < windows; i++)
+            SpectrumKernels::accumulate(power, powers.data() + i * (windowSizeH + 1), windowSizeH + 1);
+        float peak = *std::max_element(power, power + windowSizeH + 1);
+        if (peak <= 0)
+            return 0;
+        powerFloor = peak * HPS_FLOOR;
+
+        if (!autoCorrelation)
+            return harmonicProduct(confidence);
+    }
+
+    // Sum the spectra in window order so the result doesn't depend on scheduling, finding
+    // the peak while adding the last one
+    std::copy(spectra.data(), spectra.data() + windowSizeH, freqa);
+    COUNT_TRAFFIC(2 * sizeof(float) * windowSizeH);
+    for (int i = 1; i < windows - 1; i++)
+        SpectrumKernels::accumulate(freqa, spectra.data() + i * windowSizeH, windowSizeH);
+    int argmax = windows > 1 ?
+            SpectrumKernels::accumulateArgmax(freqa, spectra.data() + (windows - 1) * windowSizeH,
+                                              windowSizeH) :
+            SpectrumKernels::argmax(freqa, windowSizeH);
+
+    // The pruned peak relative to the zero lag value is how periodic the input is
+    float energy = 0;
+    for (int i = 0; i < windows; i++)
+        energy += energies[i];
+    if (energy > 0)
+        *confidence = std::min(1.0f, freqa[argmax] / energy);
+
+    // Fit a parabola through the peak for a lag between samples, which keeps decimated
+    // (lower rate) input as precise as analyzing at the full rate
+    float offset = 0;
+    if (argmax > 0 && argmax < windowSizeH - 1) {
+        float a = freqa[argmax - 1], b = freqa[argmax], c = freqa[argmax + 1];
+        float d = a - 2 * b + c;
+        if (a > 0 && c > 0 && d < 0)
+            offset = 0.5f * (a - c) / d;
+    }
+
+    float lag = (float) ((windowSizeH - 1) - argmax) - offset;
+    float frequency = (float) sampleRate / lag;
+    if (detector == FUSED)
+        frequency = resolveOctave(frequency);
+    return frequency;
+}
+
+/**
+ * Score how well a fundamental explains the summed power spectrum
+ * @param bin Fundamental as a fractional FFT bin
+ * @return Log of the product of the power at the first HPS_HARMONICS harmonics
+ */
+float FrequencyReader::harmonicScore(float bin) const {
+    float score = 0;
+    for (int h = 1; h <= HPS_HARMONICS; h++)
+        score += logf(powerAt(bin * h) + powerFloor);
+    return score;
+}
+
+/**
+ * Get the summed power spectrum between bins
+ * @param position Fractional FFT bin
+ * @return Power interpolated between the two nearest bins (0 past the end of the spectrum)
+ */
+float FrequencyReader::powerAt(float position) const {
+    int i = (int) position;
+    if (i >= windowSizeH)
+        return 0;
+    return power[i] + (power[i + 1] - power[i]) * (position - i);
+}
+
+/**
+ * Detect the fundamental with the harmonic product spectrum
+ * Candidates are searched at fractions of a bin so their harmonics line up with the
+ * spectrum, and fundamentals below HPS_RESOLVED_BIN are only reached an octave down
+ * @param confidence Set to the share of the power found at the harmonics if not null
+ * @return Frequency in hertz or 0 if nothing was detected
+ */
+float FrequencyReader::harmonicProduct(float *confidence) const {
+
+    // Only search fundamentals whose harmonics are resolved and all fit in the spectrum
+    int first = (int) (HPS_OVERSAMPLE * HPS_RESOLVED_BIN);
+    int last = HPS_OVERSAMPLE * (windowSizeH - 1) / HPS_HARMONICS;
+    int best = 0;
+    float bestScore = 0;
+    for (int c = first; c <= last; c++) {
+        float score = harmonicScore((float) c / HPS_OVERSAMPLE);
+        if (best == 0 || score > bestScore) {
+            best = c;
+            bestScore = score;
         }
-        srcPos += windowSize;
     }
+    // Every candidate interpolates two bins at each harmonic
+    COUNT_TRAFFIC(2 * sizeof(float) * HPS_HARMONICS * std::max(0, last - first + 1));
+    if (best == 0)
+        return 0;
+    return harmonicPeaks(correctOctave((float) best / HPS_OVERSAMPLE), confidence);
+}
 
-    if (windowsUsed < 1)
+/**
+ * Refine a fundamental from the interpolated peak of each harmonic, weighted by power
+ * @param bin Fundamental as a fractional FFT bin
+ * @param confidence Set to the share of the power found at the harmonics if not null
+ * @return Frequency in hertz or 0 if no harmonic was found
+ */
+float FrequencyReader::harmonicPeaks(float bin, float *confidence) const {
+    double weighted = 0, weights = 0, harmonicPower = 0;
+    for (int h = 1; h <= HPS_HARMONICS; h++) {
+        // Stop at the top of the spectrum, where the peak and its neighbors don't all fit
+        int i = (int) lroundf(bin * h);
+        if (i >= windowSizeH - 1)
+            break;
+        if (i < 1)
+            continue;
+        if (i > 1 && power[i - 1] > power[i])
+            i--;
+        else if (power[i + 1] > power[i])
+            i++;
+
+        // Parabolic interpolation of the log power
+        float a = logf(power[i - 1] + powerFloor);
+        float b = logf(power[i] + powerFloor);
+        float c = logf(power[i + 1] + powerFloor);
+        float d = a - 2 * b + c;
+        float offset = d < 0 ? 0.5f * (a - c) / d : 0;
+
+        weighted += power[i] * (i + offset);
+        weights += power[i] * h;
+        harmonicPower += power[i - 1] + power[i] + power[i + 1];
+    }
+    if (weights <= 0)
         return 0;
 
-    int argmax = 0;
-    for(int j = 1; j < windowSizeH; j++)
-        if (freqa[j] > freqa[argmax])
-            argmax = j;
+    if (confidence != nullptr) {
+        double total = 0;
+        for (int i = 1; i <= windowSizeH; i++)
+            total += power[i];
+        *confidence = (float) std::min(1.0, harmonicPower / total);
+    }
+
+    return (float) (weighted / weights * sampleRate / windowSize);
+}
+
+/**
+ * Get the power at the odd harmonics of a fundamental relative to the even ones
+ * A fundamental an octave too low has almost nothing at its odd harmonics, and one an
+ * octave too high has the real fundamental's odd harmonics between its own
+ * @param bin Fundamental as a fractional FFT bin
+ * @return Ratio of odd to even harmonic power
+ */
+float FrequencyReader::oddHarmonicRatio(float bin) const {
+    float odd = 0, even = 0;
+    for (int h = 1; h <= HPS_HARMONICS; h++)
+        (h % 2 == 1 ? odd : even) += powerAt(bin * h);
+    return even > 0 ? odd / even : 1;
+}
+
+/**
+ * Move a fundamental up or down an octave if its odd harmonics say it's off by one
+ * @param bin Fundamental as a fractional FFT bin
+ * @return Corrected fundamental bin
+ */
+float FrequencyReader::correctOctave(float bin) const {
+    float highest = (float) (windowSizeH - 1) / HPS_HARMONICS;
+    if (bin > highest)
+        return bin;
+
+    // Missing odd harmonics: the real fundamental is an octave up
+    if (bin * 2 <= highest && oddHarmonicRatio(bin) < HPS_MISSING_ODD_RATIO)
+        return bin * 2;
 
-    int lag = (windowSizeH - 1) - argmax;
-    return (float) sampleRate / lag;
+    // Odd harmonics of the octave below: that's the real fundamental
+    if (bin / 2 >= HPS_LOWEST_BIN && oddHarmonicRatio(bin / 2) >= HPS_PRESENT_ODD_RATIO)
+        return bin / 2;
+
+    return bin;
+}
+
+/**
+ * Move an autocorrelation result up or down an octave if the power spectrum says it's off,
+ * and measure it from the harmonic peaks wherever they're resolved
+ * The autocorrelation lag is biased short by the window (tens of cents on bass notes), and
+ * scaling it by an octave keeps that bias. The interpolated harmonic peaks aren't biased
+ * once the fundamental is HPS_RESOLVED_BIN or more, and are still closer than the scaled
+ * lag below that. Fundamentals whose harmonics run off the top of the spectrum keep the lag.
+ * @param frequency Autocorrelation frequency in hertz
+ * @return Corrected frequency in hertz
+ */
+float FrequencyReader::resolveOctave(float frequency) const {
+    float bin = frequency * windowSize / sampleRate;
+    float corrected = correctOctave(bin);
+    if (corrected == bin && (bin < HPS_RESOLVED_BIN || bin * HPS_HARMONICS >= windowSizeH))
+        return frequency;
+    float refined = harmonicPeaks(corrected, nullptr);
+    return refined > 0 ? refined : frequency * (corrected / bin);
 }
 
 bool FrequencyReader::computeSpectrum(WavData *wav, int channel, int wavStart,
                                       int width, float *output, bool autoCorrelation) {
+    selectWindow(plans.back());
+    return computeSpectrum(wav, channel, wavStart, width, output, autoCorrelation, scratch[0]);
+}
+
+bool FrequencyReader::computeSpectrum(WavData *wav, int channel, int wavStart, int width,
+                                      float *output, bool autoCorrelation, Scratch &scratch) {
     if (width < windowSize)
         return false;
 
-    memset(processed, 0, windowSize4);
-    memset(in, 0, windowSize4);
-    memset(out, 0, windowSize4);
-    memset(out2, 0, windowSize4);
+    float *processed = scratch.processed;
+    memset(processed, 0, windowSize2);
 
+    // Half-overlapped windows are transformed in batches, all summing into processed
+    int starts[MAX_FFT_BATCH];
+    float *targets[MAX_FFT_BATCH];
+    int count = 0;
     int start = 0;
     int windows = 0;
     while (start + windowSize <= width) {
-        memcpy(in, wav->samples + (wavStart + start) * wav->channels + channel, windowSize4);
-
-        //WindowFunc(windowFunc, windowSize, in);
-        fft->hannWindowFunc(true, in);
-
-        if (autoCorrelation) {
-            // Take FFT
-            fft->apply(in, out, out2);
-            // Compute power
-            for (int i = 0; i < windowSize; i++)
-                in[i] = (out[i] * out[i]) + (out2[i] * out2[i]);
-
-            // Tolonen and Karjalainen recommend taking the cube root
-            // of the power, instead of the square root
-
-            for (int i = 0; i < windowSize; i++)
-                in[i] = pow(in[i], 1.0f / 3.0f);
-
-            // Take FFT
-            fft->apply(in, out, out2);
-        }
-        /*else
-            PowerSpectrum(windowSize, in, out);*/
-
-        // Take real part of result
-        for (int i = 0; i < windowSizeH; i++)
-            processed[i] += out[i];
+        starts[count] = wavStart + start;
+        targets[count] = processed;
+        count++;
 
         start += windowSizeH;
         windows++;
+
+        if (count == maxBatch || start + windowSize > width) {
+            // The power spectrum path (no autocorrelation) is disabled, leaving processed at zero
+            if (autoCorrelation)
+                transformWindows(wav, channel, starts, count, targets, true, scratch);
+            count = 0;
+        }
     }
 
     if (windows < 1)
         return false;
 
-    if (autoCorrelation) {
+    finishSpectrum(processed, output, windows, autoCorrelation);
 
-        // Peak Pruning as described by Tolonen and Karjalainen, 2000
-        /*
-         Combine most of the calculations in a single for loop.
-         It should be safe, as indexes refer only to current and previous elements,
-         that have already been clipped, etc...
-        */
-        for (int i = 0; i < windowSizeH; i++) {
-            // Clip at zero, copy to temp array
-            if (processed[i] < 0.0)
-                processed[i] = 0;
-            out[i] = processed[i];
-            // Subtract a time-doubled signal (linearly interp.) from the original
-            // (clipped) signal
-            if ((i % 2) == 0)
-                processed[i] -= out[i / 2];
-            else
-                processed[i] -= ((out[i / 2] + out[i / 2 + 1]) / 2);
+    return true;
+}
+
+/**
+ * Compute the enhanced autocorrelation of a batch of windows and add the real part of the
+ * first half of each to its target
+ * @param wav Wav data
+ * @param channel Channel to read
+ * @param starts Start frame of each window
+ * @param count Number of windows (up to maxBatch)
+ * @param targets Array each window's result is stored to, or null to stop after the power spectrum
+ * @param accumulate True to add to the targets (which may then be shared between windows)
+ *                   instead of overwriting them
+ * @param scratch Worker buffers
+ * @param powers Array each window's power spectrum (windowSizeH + 1 bins) is stored to if not null
+ */
+void FrequencyReader::transformWindows(WavData *wav, int channel, const int *starts, int count,
+                                       float *const *targets, bool accumulate, Scratch &scratch,
+                                       float *const *powers) {
+    float *batch = scratch.batch;
+    float *re = scratch.re;
+    float *im = scratch.im;
+    int channels = wav->channels;
+
+    // Gather the windows into structure-of-arrays layout while applying the Hann window
+    COUNT_TRAFFIC(3 * sizeof(float) * windowSize * count);
+    for (int k = 0; k < count; k++) {
+        const float *src = wav->samples + starts[k] * channels + channel;
+        for (int j = 0; j < windowSize; j++)
+            batch[j * count + k] = src[j * channels] * window[j];
+    }
 
-            // Clip at zero again
-            if (processed[i] < 0.0)
-                processed[i] = 0;
+    // Take FFT
+    fft->applyBatch(batch, re, im, count);
+
+    // Compute power
+    // Tolonen and Karjalainen recommend taking the cube root
+    // of the power, instead of the square root
+    COUNT_TRAFFIC((2 + (targets != nullptr) + (powers != nullptr)) * sizeof(float) *
+                  (windowSizeH + 1) * count);
+    for (int i = 0; i <= windowSizeH; i++) {
+        float *dst = batch + i * count;
+        const float *r = re + i * count;
+        const float *m = im + i * count;
+        if (powers == nullptr) {
+            for (int k = 0; k < count; k++)
+                dst[k] = cbrtf((r[k] * r[k]) + (m[k] * m[k]));
+        } else if (targets == nullptr) {
+            for (int k = 0; k < count; k++)
+                powers[k][i] = (r[k] * r[k]) + (m[k] * m[k]);
+        } else {
+            // Keep the power before the cube root for the harmonic product
+            for (int k = 0; k < count; k++) {
+                float p = (r[k] * r[k]) + (m[k] * m[k]);
+                powers[k][i] = p;
+                dst[k] = cbrtf(p);
+            }
+        }
+    }
+    if (targets == nullptr)
+        return;
+
+    // The power spectrum is real and symmetric, so the second FFT is a real-even transform
+    // of its first half. The unused upper half of the batch buffer serves as a work area.
+    evenFft->applyRealEven(batch, re, im, batch + (windowSizeH + 1) * count, count);
+
+    // Take real part of result
+    COUNT_TRAFFIC((accumulate ? 3 : 2) * sizeof(float) * windowSizeH * count);
+    for (int i = 0; i < windowSizeH; i++) {
+        const float *r = re + i * count;
+        if (accumulate) {
+            for (int k = 0; k < count; k++)
+                targets[k][i] += r[k];
+        } else {
+            for (int k = 0; k < count; k++)
+                targets[k][i] = r[k];
         }
+    }
+}
+
+/**
+ * Turn accumulated autocorrelation values into the final spectrum
+ * @param processed Accumulated values
+ * @param output Output spectrum (windowSizeH values)
+ * @param windows Number of windows that were accumulated
+ * @param autoCorrelation True if the values are an autocorrelation
+ * @param energy Set to the scaled zero lag value of the autocorrelation if not null
+ */
+void FrequencyReader::finishSpectrum(const float *processed, float *output, int windows,
+                                     bool autoCorrelation, float *energy) {
+    if (autoCorrelation) {
+        float scale = windowSize / 4;
+
+        // Pruning always removes the zero lag, so keep it for normalizing the peak
+        if (energy != nullptr)
+            *energy = std::max(0.0f, processed[0] / scale);
 
-        // Reverse and scale
-        for (int i = 0; i < windowSizeH; i++)
-            in[i] = processed[i] / (windowSize / 4);
-        for (int i = 0; i < windowSizeH; i++)
-            processed[windowSizeH - 1 - i] = in[i];
+        // Peak Pruning as described by Tolonen and Karjalainen, 2000, reversed and scaled
+        // straight into the output (the scale is a power of two, so its inverse is exact)
+        SpectrumKernels::prunePeaks(processed, output, windowSizeH, 1 / scale);
     } else {
         // Convert to decibels
         // But do it safely; -Inf is nobody's friend
         for (int i = 0; i < windowSizeH; i++){
             double temp = (processed[i] / windowSize / windows);
             if (temp > 0.0)
-                processed[i] = 10 * log10(temp);
+                output[i] = 10 * log10(temp);
             else
-                processed[i] = 0;
+                output[i] = 0;
         }
     }
+}
+
+/**
+ * Select how the fundamental is detected
+ * @param detector Detector to use
+ */
+void FrequencyReader::setDetector(Detector detector) {
+    this->detector = detector;
+}
+
+/**
+ * Get the detector in use
+ * @return Detector
+ */
+FrequencyReader::Detector FrequencyReader::getDetector() const {
+    return detector;
+}
 
-    memcpy(output, processed, windowSize2);
+/**
+ * Get the size of each analysis window
+ * @return Window size in frames
+ */
+int FrequencyReader::getWindowSize() const {
+    return plans.back().size;
+}
 
-    return true;
-}
\ No newline at end of file
+/**
+ * Get the window size the last analysis used
+ * @return Window size in samples
+ */
+int FrequencyReader::getLastWindowSize() const {
+    return windowSize;
+}
+
+/**
+ * Size each analysis window from the last confident pitch instead of always using the full
+ * window, so high notes are analyzed with less input and work
+ * @param adaptive True to size windows from the pitch
+ */
+void FrequencyReader::setAdaptiveWindow(bool adaptive) {
+    this->adaptive = adaptive;
+    resetTracking();
+}
+
+/**
+ * Forget the tracked pitch, so the next analysis starts from the full window
+ * Adaptive sizing stays on or off as it was
+ */
+void FrequencyReader::resetTracking() {
+    trackedFrequency = 0;
+}
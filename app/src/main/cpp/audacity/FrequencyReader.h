@@ -2,31 +2,134 @@
 #define TUNEBLOB_FREQUENCYREADER_H
 
 
+#include <memory>
+#include <vector>
 #include "FFT.h"
 #include "../data/WavData.h"
+#include "../thread/WorkerPool.h"
+
+// Number of harmonics multiplied by the harmonic product detector
+static const int HPS_HARMONICS = 5;
+
+// Candidate fundamentals per FFT bin searched by the harmonic product detector
+static const int HPS_OVERSAMPLE = 8;
+
+// Harmonics of lower fundamentals than this (in FFT bins) overlap in the Hann window's
+// main lobe, so they are only reached by octave correction
+static const float HPS_RESOLVED_BIN = 3.0f;
+
+// Lowest fundamental (in FFT bins) octave correction can move to
+static const float HPS_LOWEST_BIN = 1.5f;
+
+// Harmonics weaker than this relative to the strongest bin count as missing
+static const float HPS_FLOOR = 1e-4f;
+
+// Odd to even harmonic power below which a fundamental is taken to be an octave too low,
+// and above which the octave below a fundamental is taken to be the real one
+static const float HPS_MISSING_ODD_RATIO = 0.1f;
+static const float HPS_PRESENT_ODD_RATIO = 0.4f;
+
+// Periods of the last pitch an adaptive window has to hold, which leaves room for the
+// pitch to drop two octaves before it falls out of the window's lag range
+static const int ADAPTIVE_MIN_PERIODS = 8;
+
+// Smallest window adaptive sizing goes down to
+static const int ADAPTIVE_MIN_WINDOW = 256;
+
+// Confidence a pitch needs before the window is sized from it
+static const float ADAPTIVE_MIN_CONFIDENCE = 0.5f;
 
 class FrequencyReader {
 public:
 
-    FrequencyReader(int sampleRate, float minAmplitude);
+    /**
+     * How the fundamental is picked from the analyzed windows
+     */
+    enum Detector {
+        AUTOCORRELATION,    // Enhanced autocorrelation peak (default)
+        HARMONIC_PRODUCT,   // Harmonic product of the power spectrum only (skips the second FFT)
+        FUSED               // Autocorrelation, with the harmonic product resolving octave errors
+    };
+
+    FrequencyReader(int sampleRate, float minAmplitude,
+                    std::shared_ptr<WorkerPool> pool = WorkerPool::getShared());
     ~FrequencyReader();
 
-    float getFrequency(WavData *wav, int channel, int startFrame, int scanFrames);
+    float getFrequency(WavData *wav, int channel, int startFrame, int scanFrames,
+                       float *confidence = nullptr);
     bool computeSpectrum(WavData *wav, int channel, int wavStart, int width, float *output, bool autoCorrelation);
+    int getWindowSize() const;
+    int getLastWindowSize() const;
+    int getNextScan(int numFrames, int &startFrame, int &scanFrames) const;
+    void setDetector(Detector detector);
+    Detector getDetector() const;
+    void setAdaptiveWindow(bool adaptive);
+    void resetTracking();
 
 private:
 
+    /**
+     * FFT plans and Hann window for one window size, all built up front
+     */
+    struct WindowPlan {
+        int size;
+        int maxBatch;
+        std::shared_ptr<FFT> fft;
+        std::shared_ptr<FFT> evenFft;
+        float *window;
+    };
+
+    /**
+     * Buffers used while computing the spectrum of a batch of windows (one set per worker)
+     */
+    struct Scratch {
+        float *processed;
+        float *batch;
+        float *re;
+        float *im;
+    };
+
+    float detectFrequency(WavData *wav, int channel, int startFrame, int scanFrames,
+                          float *confidence);
+    const WindowPlan &adaptiveWindow() const;
+    static WindowPlan buildPlan(int size);
+    void selectWindow(const WindowPlan &plan);
+    bool computeSpectrum(WavData *wav, int channel, int wavStart, int width, float *output,
+                         bool autoCorrelation, Scratch &scratch);
+    void transformWindows(WavData *wav, int channel, const int *starts, int count,
+                          float *const *targets, bool accumulate, Scratch &scratch,
+                          float *const *powers = nullptr);
+    void finishSpectrum(const float *processed, float *output, int windows, bool autoCorrelation,
+                        float *energy = nullptr);
+    float powerAt(float position) const;
+    float harmonicScore(float bin) const;
+    float harmonicProduct(float *confidence) const;
+    float harmonicPeaks(float bin, float *confidence) const;
+    float oddHarmonicRatio(float bin) const;
+    float correctOctave(float bin) const;
+    float resolveOctave(float frequency) const;
+
     const int sampleRate;
     const float minAmplitude;
     int windowSize, windowSizeH, windowSize2, windowSize4;
     std::shared_ptr<FFT> fft;
+    std::shared_ptr<FFT> evenFft;
+    std::shared_ptr<WorkerPool> pool;
+    int maxBatch;
+    Detector detector = AUTOCORRELATION;
+    bool adaptive = false;
+    float trackedFrequency = 0;     // Last confident pitch, or 0 to use the full window
 
-    float *processed;
-    float *in;
-    float *out;
-    float *out2;
-    float *freq;
+    std::vector<WindowPlan> plans;  // Every power of two up to the full window, smallest first
+    WindowPlan bassPlan;            // Twice the full window, for fused results near its longest lag
+    std::vector<Scratch> scratch;
+    std::vector<float> spectra;
+    std::vector<float> energies;
+    std::vector<float> powers;
+    float *window;
     float *freqa;
+    float *power;
+    float powerFloor;
 };
 
 
@@ -0,0 +1,216 @@
+#include <algorithm>
+#include <cstdint>
+#include "SpectrumKernels.h"
+#include "../debug/TrafficCounter.h"
+
+// A path picked before this point wins: SPECTRUM_KERNELS_SCALAR builds only the scalar
+// code, which the post_process bench checks the vector paths against
+#if defined(SPECTRUM_KERNELS_SCALAR) || defined(SPECTRUM_KERNELS_NEON) || defined(SPECTRUM_KERNELS_SSE2)
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SPECTRUM_KERNELS_NEON
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SPECTRUM_KERNELS_SSE2
+#endif
+
+/**
+ * Peak pruning as described by Tolonen and Karjalainen, 2000, fused with reversing and
+ * scaling into the output
+ * Each value is clipped at zero, the time-doubled (linearly interpolated) signal is
+ * subtracted and the result is clipped again. Lag i is written to out[count - 1 - i].
+ * The vector loops take 8 lags at a time: the time-doubled signal of lags i to i + 7 is
+ * lags i / 2 to i / 2 + 3 interleaved with their midpoints, so there's no odd/even branch.
+ * @param in Autocorrelation values
+ * @param out Output spectrum (count values, can't overlap in)
+ * @param count Number of lags
+ * @param scale Factor applied to the output (a power of two keeps it exact)
+ */
+void SpectrumKernels::prunePeaks(const float *in, float *out, int count, float scale) {
+    // Each lag loads itself and half of the two time-doubled points, and stores one value
+    COUNT_TRAFFIC(3 * sizeof(float) * count);
+    int i = 0;
+#if defined(SPECTRUM_KERNELS_NEON)
+    const float32x4_t zero = vdupq_n_f32(0), half = vdupq_n_f32(0.5f), gain = vdupq_n_f32(scale);
+    for (; i + 8 <= count; i += 8) {
+        const float *h = in + i / 2;
+        float32x4_t lo = vmaxq_f32(vld1q_f32(h), zero);
+        float32x4_t hi = vmaxq_f32(vld1q_f32(h + 1), zero);
+        float32x4x2_t doubled = vzipq_f32(lo, vmulq_f32(vaddq_f32(lo, hi), half));
+        float32x4_t a = vmaxq_f32(vld1q_f32(in + i), zero);
+        float32x4_t b = vmaxq_f32(vld1q_f32(in + i + 4), zero);
+        a = vmulq_f32(vmaxq_f32(vsubq_f32(a, doubled.val[0]), zero), gain);
+        b = vmulq_f32(vmaxq_f32(vsubq_f32(b, doubled.val[1]), zero), gain);
+        a = vrev64q_f32(a);
+        b = vrev64q_f32(b);
+        vst1q_f32(out + count - 4 - i, vcombine_f32(vget_high_f32(a), vget_low_f32(a)));
+        vst1q_f32(out + count - 8 - i, vcombine_f32(vget_high_f32(b), vget_low_f32(b)));
+    }
+#elif defined(SPECTRUM_KERNELS_SSE2)
+    const __m128 zero = _mm_setzero_ps(), half = _mm_set1_ps(0.5f), gain = _mm_set1_ps(scale);
+    for (; i + 8 <= count; i += 8) {
+        const float *h = in + i / 2;
+        __m128 lo = _mm_max_ps(_mm_loadu_ps(h), zero);
+        __m128 hi = _mm_max_ps(_mm_loadu_ps(h + 1), zero);
+        __m128 mid = _mm_mul_ps(_mm_add_ps(lo, hi), half);
+        __m128 a = _mm_max_ps(_mm_loadu_ps(in + i), zero);
+        __m128 b = _mm_max_ps(_mm_loadu_ps(in + i + 4), zero);
+        a = _mm_mul_ps(_mm_max_ps(_mm_sub_ps(a, _mm_unpacklo_ps(lo, mid)), zero), gain);
+        b = _mm_mul_ps(_mm_max_ps(_mm_sub_ps(b, _mm_unpackhi_ps(lo, mid)), zero), gain);
+        _mm_storeu_ps(out + count - 4 - i, _mm_shuffle_ps(a, a, _MM_SHUFFLE(0, 1, 2, 3)));
+        _mm_storeu_ps(out + count - 8 - i, _mm_shuffle_ps(b, b, _MM_SHUFFLE(0, 1, 2, 3)));
+    }
+#endif
+    // Zero first, so -0 clips to +0 like the vector max instructions
+    for (; i < count; i++) {
+        float value = std::max(0.0f, in[i]);
+        float doubled = std::max(0.0f, in[i / 2]);
+        if ((i % 2) != 0)
+            doubled = (doubled + std::max(0.0f, in[i / 2 + 1])) * 0.5f;
+        out[count - 1 - i] = std::max(0.0f, value - doubled) * scale;
+    }
+}
+
+/**
+ * Add one array to another
+ * @param sum Array added to
+ * @param add Array to add
+ * @param count Number of values
+ */
+void SpectrumKernels::accumulate(float *sum, const float *add, int count) {
+    COUNT_TRAFFIC(3 * sizeof(float) * count);
+    int i = 0;
+#if defined(SPECTRUM_KERNELS_NEON)
+    for (; i + 4 <= count; i += 4)
+        vst1q_f32(sum + i, vaddq_f32(vld1q_f32(sum + i), vld1q_f32(add + i)));
+#elif defined(SPECTRUM_KERNELS_SSE2)
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_ps(sum + i, _mm_add_ps(_mm_loadu_ps(sum + i), _mm_loadu_ps(add + i)));
+#endif
+    for (; i < count; i++)
+        sum[i] += add[i];
+}
+
+/**
+ * Add one array to another and find the largest value of the result in the same pass
+ * @param sum Array added to
+ * @param add Array to add
+ * @param count Number of values (must be at least 1)
+ * @return Index of the first largest value
+ */
+int SpectrumKernels::accumulateArgmax(float *sum, const float *add, int count) {
+    return scanMax<true>(sum, add, count);
+}
+
+/**
+ * Find the largest value of an array
+ * @param values Array to scan
+ * @param count Number of values (must be at least 1)
+ * @return Index of the first largest value
+ */
+int SpectrumKernels::argmax(const float *values, int count) {
+    // Nothing is written without accumulating
+    return scanMax<false>(const_cast<float *>(values), nullptr, count);
+}
+
+/**
+ * Branch-free argmax, optionally adding another array first
+ * Each lane keeps its own best value and index, only replacing them with strictly larger
+ * values, so ties between lanes go to the lowest index like a scalar scan
+ * @param values Array to scan (and add to)
+ * @param add Array to add if accumulating
+ * @param count Number of values (must be at least 1)
+ * @return Index of the first largest value
+ */
+template<bool Accumulate>
+int SpectrumKernels::scanMax(float *values, const float *add, int count) {
+    COUNT_TRAFFIC((Accumulate ? 3 : 1) * sizeof(float) * count);
+    int i = 0;
+    int best = 0;
+    float bestValue = 0;
+#if defined(SPECTRUM_KERNELS_NEON)
+    if (count >= 4) {
+        float32x4_t maxes = vld1q_f32(values);
+        if (Accumulate) {
+            maxes = vaddq_f32(maxes, vld1q_f32(add));
+            vst1q_f32(values, maxes);
+        }
+        const uint32_t first[4] = {0, 1, 2, 3};
+        uint32x4_t index = vld1q_u32(first), indexes = index;
+        const uint32x4_t step = vdupq_n_u32(4);
+        for (i = 4; i + 4 <= count; i += 4) {
+            float32x4_t a = vld1q_f32(values + i);
+            if (Accumulate) {
+                a = vaddq_f32(a, vld1q_f32(add + i));
+                vst1q_f32(values + i, a);
+            }
+            index = vaddq_u32(index, step);
+            uint32x4_t greater = vcgtq_f32(a, maxes);
+            maxes = vbslq_f32(greater, a, maxes);
+            indexes = vbslq_u32(greater, index, indexes);
+        }
+        float laneValues[4];
+        uint32_t laneIndexes[4];
+        vst1q_f32(laneValues, maxes);
+        vst1q_u32(laneIndexes, indexes);
+        best = (int) laneIndexes[0];
+        bestValue = laneValues[0];
+        for (int l = 1; l < 4; l++) {
+            if (laneValues[l] > bestValue ||
+                (laneValues[l] == bestValue && (int) laneIndexes[l] < best)) {
+                best = (int) laneIndexes[l];
+                bestValue = laneValues[l];
+            }
+        }
+    }
+#elif defined(SPECTRUM_KERNELS_SSE2)
+    if (count >= 4) {
+        __m128 maxes = _mm_loadu_ps(values);
+        if (Accumulate) {
+            maxes = _mm_add_ps(maxes, _mm_loadu_ps(add));
+            _mm_storeu_ps(values, maxes);
+        }
+        __m128i index = _mm_setr_epi32(0, 1, 2, 3), indexes = index;
+        const __m128i step = _mm_set1_epi32(4);
+        for (i = 4; i + 4 <= count; i += 4) {
+            __m128 a = _mm_loadu_ps(values + i);
+            if (Accumulate) {
+                a = _mm_add_ps(a, _mm_loadu_ps(add + i));
+                _mm_storeu_ps(values + i, a);
+            }
+            index = _mm_add_epi32(index, step);
+            __m128 greater = _mm_cmpgt_ps(a, maxes);
+            __m128i mask = _mm_castps_si128(greater);
+            maxes = _mm_or_ps(_mm_and_ps(greater, a), _mm_andnot_ps(greater, maxes));
+            indexes = _mm_or_si128(_mm_and_si128(mask, index), _mm_andnot_si128(mask, indexes));
+        }
+        float laneValues[4];
+        int32_t laneIndexes[4];
+        _mm_storeu_ps(laneValues, maxes);
+        _mm_storeu_si128((__m128i *) laneIndexes, indexes);
+        best = laneIndexes[0];
+        bestValue = laneValues[0];
+        for (int l = 1; l < 4; l++) {
+            if (laneValues[l] > bestValue || (laneValues[l] == bestValue && laneIndexes[l] < best)) {
+                best = laneIndexes[l];
+                bestValue = laneValues[l];
+            }
+        }
+    }
+#endif
+    if (i == 0) {
+        if (Accumulate)
+            values[0] += add[0];
+        bestValue = values[0];
+        i = 1;
+    }
+    for (; i < count; i++) {
+        if (Accumulate)
+            values[i] += add[i];
+        if (values[i] > bestValue) {
+            best = i;
+            bestValue = values[i];
+        }
+    }
+    return best;
+}
@@ -0,0 +1,24 @@
+#ifndef TUNEBLOB_SPECTRUMKERNELS_H
+#define TUNEBLOB_SPECTRUMKERNELS_H
+
+/**
+ * Vectorized post-processing of autocorrelation spectra for the FrequencyReader
+ * Uses NEON on ARM and SSE2 on x86, with a scalar fallback for everything else. Results
+ * match the scalar code exactly, so the detected pitch doesn't depend on the platform.
+ */
+class SpectrumKernels {
+public:
+
+    static void prunePeaks(const float *in, float *out, int count, float scale);
+    static void accumulate(float *sum, const float *add, int count);
+    static int accumulateArgmax(float *sum, const float *add, int count);
+    static int argmax(const float *values, int count);
+
+private:
+
+    template<bool Accumulate> static int scanMax(float *values, const float *add, int count);
+
+};
+
+
+#endif //TUNEBLOB_SPECTRUMKERNELS_H
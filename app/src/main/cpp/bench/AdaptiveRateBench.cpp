@@ -0,0 +1,153 @@
+/*
+ * Analysis work and response times of the engine with and without the stability-aware
+ * analysis rate, over a scripted take with held notes, a re-pluck, a legato note change and
+ * a drop in level
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <thread>
+#include <vector>
+#include "Bench.h"
+#include "../PI.h"
+#include "../audacity/FrequencyReader.h"
+#include "../tuner/TunerInputEngine.h"
+#include "../input/ThreadedInputSource.h"
+
+static const int SAMPLE_RATE = 48000;
+static const float SPEED = 4;
+static const double TAKE_SECONDS = 6;
+static const float BUFFER_SECONDS = 0.2f;
+
+// Scripted events (seconds)
+static const double REPLUCK_TIME = 2;
+static const double LEGATO_TIME = 3;
+static const double DROP_TIME = 4.5;
+static const double FIRST_NOTE = 110.0;
+static const double SECOND_NOTE = 146.83;
+
+/**
+ * Plays a prepared take
+ */
+class TakeSource : public ThreadedInputSource {
+public:
+
+    explicit TakeSource(const std::vector<float> &take)
+    : ThreadedInputSource(SAMPLE_RATE, 256, SPEED), take(take) {
+    }
+
+    ~TakeSource() override {
+        stop();
+    }
+
+protected:
+
+    int read(float *out, int maxFrames) override {
+        int count = std::min(maxFrames, (int) take.size() - pos);
+        std::copy(take.begin() + pos, take.begin() + pos + count, out);
+        pos += count;
+        return count;
+    }
+
+private:
+
+    const std::vector<float> &take;
+    int pos = 0;
+};
+
+/**
+ * Build the take: a decaying A2, plucked again, sliding to D3 without a new attack, then
+ * dropping 12 dB
+ * @return Samples
+ */
+static std::vector<float> buildTake() {
+    std::vector<float> take((size_t) (TAKE_SECONDS * SAMPLE_RATE));
+    double phase = 0;
+    for (size_t i = 0; i < take.size(); i++) {
+        double t = (double) i / SAMPLE_RATE;
+        double sinceAttack = t < REPLUCK_TIME ? t : t - REPLUCK_TIME;
+        double amp = 0.5 * exp(-sinceAttack / 3) * (t < DROP_TIME ? 1 : 0.25);
+        phase += 2 * PI * (t < LEGATO_TIME ? FIRST_NOTE : SECOND_NOTE) / SAMPLE_RATE;
+        double sample = 0;
+        for (int n = 1; n <= 3; n++)
+            sample += sin(n * phase) / n;
+        take[i] = (float) (amp * sample);
+    }
+    return take;
+}
+
+/**
+ * Time from an event to the first result after it
+ * @param entries Results
+ * @param event Event time in seconds
+ * @param note Frequency the result has to be within 20 cents of, or 0 for any result
+ * @return Delay in milliseconds, or -1 if no result matched
+ */
+static double responseMs(const std::vector<PitchHistory::Entry> &entries, double event, double note) {
+    for (const PitchHistory::Entry &e : entries) {
+        if (e.time < event)
+            continue;
+        if (note > 0 && fabs(1200 * log2(e.frequency / note)) > 20)
+            continue;
+        return (e.time - event) * 1000;
+    }
+    return -1;
+}
+
+/**
+ * Play the take through an engine
+ * @param take Samples
+ * @param adaptive True to use the stability-aware analysis rate
+ */
+static void runTake(const std::vector<float> &take, bool adaptive) {
+    TunerInputEngine engine;
+    engine.setParameters(BUFFER_SECONDS, 0.01f, 1000, false);
+    engine.setAdaptiveRate(adaptive);
+    auto source = std::make_shared<TakeSource>(take);
+
+    std::clock_t cpuStart = std::clock();
+    if (engine.start(source) != 0) {
+        printf("couldn't start the engine\n");
+        return;
+    }
+
+    std::vector<PitchHistory::Entry> entries;
+    PitchHistory::Entry block[256];
+    int64_t since = 0;
+    while (!source->isFinished()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        int count;
+        while ((count = engine.fetchHistory(since, block, 256)) > 0)
+            entries.insert(entries.end(), block, block + count);
+    }
+    engine.stop();
+    double cpuMs = (double) (std::clock() - cpuStart) / CLOCKS_PER_SEC * 1000;
+    int count;
+    while ((count = engine.fetchHistory(since, block, 256)) > 0)
+        entries.insert(entries.end(), block, block + count);
+
+    printf("%-9s  analyzed %3lld  skipped %3lld hops  CPU %6.1f ms   re-pluck %5.1f ms  "
+           "legato %5.1f ms  drop %5.1f ms\n", adaptive ? "adaptive" : "every hop",
+           (long long) engine.getAnalyzedHops(), (long long) engine.getSkippedHops(), cpuMs,
+           responseMs(entries, REPLUCK_TIME, 0), responseMs(entries, LEGATO_TIME, SECOND_NOTE),
+           responseMs(entries, DROP_TIME, 0));
+}
+
+/**
+ * Compare a steady analysis rate with the stability-aware one
+ */
+void benchAdaptiveRate() {
+    std::vector<float> take = buildTake();
+    printf("%.0f s take at %d Hz, re-pluck at %.1f s, legato %.0f -> %.0f Hz at %.1f s, "
+           "-12 dB at %.1f s\n", TAKE_SECONDS, SAMPLE_RATE, REPLUCK_TIME, FIRST_NOTE, SECOND_NOTE,
+           LEGATO_TIME, DROP_TIME);
+
+    // Responses are timed to the end of the first matching buffer, so they move in whole hops
+    // and depend on the buffer length and the engine's detector (results are deterministic)
+    int hop = FrequencyReader(SAMPLE_RATE, 0.01f).getWindowSize() / 2;
+    printf("%.1f s buffer, hop %d frames (%.1f ms), sources at %.0fx real time\n", BUFFER_SECONDS,
+           hop, 1000.0 * hop / SAMPLE_RATE, SPEED);
+    runTake(take, false);
+    runTake(take, true);
+}
@@ -0,0 +1,112 @@
+/*
+ * Cost, input span and accuracy of pitch-adaptive window sizing against always using the
+ * full window, and how quickly it falls back when the pitch jumps down
+ */
+
+#include <cmath>
+#include <vector>
+#include "Bench.h"
+#include "../PI.h"
+#include "../audacity/FrequencyReader.h"
+
+static const int RATES[] = {44100, 48000};
+static const float BUFFER_SECONDS = 0.2f;
+
+// Guitar strings from low E up, and two octaves above the high E
+static const double NOTES[] = {82.41, 110.0, 146.8, 196.0, 246.9, 329.6, 659.3, 1318.5};
+
+/**
+ * Generate a tone with four harmonics
+ * @param out Output samples
+ * @param count Number of samples
+ * @param freq Fundamental in hertz
+ * @param sampleRate Sample rate
+ */
+static void tone(float *out, int count, double freq, int sampleRate) {
+    for (int i = 0; i < count; i++) {
+        double sample = 0;
+        for (int n = 1; n <= 4; n++)
+            sample += 0.3 / n * sin(2 * PI * freq * n * i / sampleRate + n);
+        out[i] = (float) sample;
+    }
+}
+
+/**
+ * Error of a detected frequency
+ * @param freq Detected frequency
+ * @param note Expected frequency
+ * @return Error in cents (1200 if nothing was detected)
+ */
+static double cents(float freq, double note) {
+    return freq > 0 ? fabs(1200 * log2(freq / note)) : 1200;
+}
+
+/**
+ * Compare full and adaptive windows on held notes, then jump from the highest note to the
+ * lowest one
+ */
+void benchAdaptiveWindow() {
+    for (int rate : RATES) {
+        int frames = (int) (BUFFER_SECONDS * rate);
+        WavData wav(1, frames, rate, new float[frames], true);
+        FrequencyReader full(rate, 0.01f, std::make_shared<WorkerPool>(0));
+        FrequencyReader adaptive(rate, 0.01f, std::make_shared<WorkerPool>(0));
+        full.setDetector(FrequencyReader::FUSED);
+        adaptive.setDetector(FrequencyReader::FUSED);
+        adaptive.setAdaptiveWindow(true);
+        printf("%d Hz, full window %d\n", rate, full.getWindowSize());
+
+        const int queries = 20;
+        for (double note : NOTES) {
+            tone(wav.samples, frames, note, rate);
+            float fullFreq = 0, adaptiveFreq = 0, confidence = 0;
+
+            // The first query always uses the full window
+            adaptive.getFrequency(&wav, 0, 0, frames);
+
+            BenchTimer fullTimer;
+            for (int q = 0; q < queries; q++)
+                fullFreq = full.getFrequency(&wav, 0, 0, frames);
+            double fullUs = fullTimer.elapsedNanos() / queries / 1000;
+
+            BenchTimer adaptiveTimer;
+            for (int q = 0; q < queries; q++)
+                adaptiveFreq = adaptive.getFrequency(&wav, 0, 0, frames, &confidence);
+            double adaptiveUs = adaptiveTimer.elapsedNanos() / queries / 1000;
+
+            int windows = std::max(1, frames / full.getWindowSize());
+            int window = adaptive.getLastWindowSize();
+            printf("  %7.2f Hz  full %6.1f us %5.1f cents   adaptive %4d %6.1f us %5.1f cents  "
+                   "span %5.1f -> %5.1f ms  confidence %.2f\n", note,
+                   fullUs, cents(fullFreq, note), window, adaptiveUs, cents(adaptiveFreq, note),
+                   1000.0 * windows * full.getWindowSize() / rate,
+                   1000.0 * windows * window / rate, confidence);
+        }
+
+        // Lock onto the highest note, then drop to the lowest
+        int last = sizeof(NOTES) / sizeof(NOTES[0]) - 1;
+        tone(wav.samples, frames, NOTES[last], rate);
+        adaptive.getFrequency(&wav, 0, 0, frames);
+        adaptive.getFrequency(&wav, 0, 0, frames);
+        int scanStart = 0, scanFrames = frames;
+        int scanWindow = adaptive.getNextScan(frames, scanStart, scanFrames);
+        printf("  next scan after %.2f Hz: frames %d-%d, window %d\n", NOTES[last], scanStart,
+               scanStart + scanFrames, scanWindow);
+        tone(wav.samples, frames, NOTES[0], rate);
+        printf("  jump %.2f -> %.2f Hz:", NOTES[last], NOTES[0]);
+        for (int hop = 0; hop < 3; hop++) {
+            float freq = adaptive.getFrequency(&wav, 0, 0, frames);
+            int window = adaptive.getLastWindowSize();
+            printf("  hop %d window %4d -> %.2f Hz", hop, window, freq);
+        }
+        printf("\n");
+
+        // A silent gap resets the window, so the next note starts from the full one
+        adaptive.getFrequency(&wav, 0, 0, frames);
+        adaptive.resetTracking();
+        scanStart = 0, scanFrames = frames;
+        scanWindow = adaptive.getNextScan(frames, scanStart, scanFrames);
+        printf("  next scan after a reset: frames %d-%d, window %d\n", scanStart,
+               scanStart + scanFrames, scanWindow);
+    }
+}
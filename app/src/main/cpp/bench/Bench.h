@@ -0,0 +1,33 @@
+#ifndef TUNEBLOB_BENCH_H
+#define TUNEBLOB_BENCH_H
+
+#include <chrono>
+#include <cstdio>
+
+/**
+ * Wall clock timer used by the host benchmarks
+ */
+class BenchTimer {
+public:
+
+    BenchTimer() : start(std::chrono::steady_clock::now()) {}
+
+    /**
+     * Get the time since the timer was created
+     * @return Elapsed time in nanoseconds
+     */
+    double elapsedNanos() const {
+        return (double) std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count();
+    }
+
+private:
+
+    std::chrono::steady_clock::time_point start;
+
+};
+
+void benchKeep(double value);
+void benchSine(float *out, int count, double freq, int sampleRate, float amp);
+
+#endif //TUNEBLOB_BENCH_H
@@ -0,0 +1,91 @@
+/*
+ * Host benchmarks for the native tuner pipeline
+ * Usage: tuner_bench [benchmark name]
+ */
+
+#include <cmath>
+#include <cstring>
+#include "Bench.h"
+#include "../PI.h"
+
+void benchInputFormat();
+void benchLevelIndex();
+void benchParallelWindows();
+void benchFftBatch();
+void benchRealEven();
+void benchRealtimeGuard();
+void benchStreamLoad();
+void benchHarmonicProduct();
+void benchHighRate();
+void benchStrobe();
+void benchPipeline();
+void benchAdaptiveWindow();
+void benchAdaptiveRate();
+void benchPostProcess();
+void benchPhaseTrack();
+
+/**
+ * Registered benchmarks
+ */
+static const struct {
+    const char *name;
+    void (*run)();
+} BENCHMARKS[] = {
+        {"input_format", benchInputFormat},
+        {"level_index", benchLevelIndex},
+        {"parallel_windows", benchParallelWindows},
+        {"fft_batch", benchFftBatch},
+        {"real_even", benchRealEven},
+        {"rt_guard", benchRealtimeGuard},
+        {"stream_load", benchStreamLoad},
+        {"harmonic_product", benchHarmonicProduct},
+        {"high_rate", benchHighRate},
+        {"strobe", benchStrobe},
+        {"pipeline", benchPipeline},
+        {"adaptive_window", benchAdaptiveWindow},
+        {"adaptive_rate", benchAdaptiveRate},
+        {"post_process", benchPostProcess},
+        {"phase_track", benchPhaseTrack},
+};
+
+// Sink for computed values so the optimizer can't drop benchmark work
+static volatile double sink = 0;
+
+/**
+ * Keep a computed value alive
+ * @param value Value to keep
+ */
+void benchKeep(double value) {
+    sink = sink + value;
+}
+
+/**
+ * Generate a sine wave
+ * @param out Output samples
+ * @param count Number of samples
+ * @param freq Frequency in hertz
+ * @param sampleRate Sample rate
+ * @param amp Amplitude (0 to 1)
+ */
+void benchSine(float *out, int count, double freq, int sampleRate, float amp) {
+    for (int i = 0; i < count; i++)
+        out[i] = amp * (float) sin(2 * PI * freq * i / sampleRate);
+}
+
+int main(int argc, char **argv) {
+    const char *only = argc > 1 ? argv[1] : nullptr;
+    int ran = 0;
+    for (const auto &bench : BENCHMARKS) {
+        if (only != nullptr && strcmp(only, bench.name) != 0)
+            continue;
+        printf("== %s ==\n", bench.name);
+        bench.run();
+        printf("\n");
+        ran++;
+    }
+    if (ran == 0) {
+        fprintf(stderr, "Unknown benchmark: %s\n", only);
+        return 1;
+    }
+    return 0;
+}
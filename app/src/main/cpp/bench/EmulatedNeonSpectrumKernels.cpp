@@ -0,0 +1,13 @@
+/*
+ * The NEON path of the spectrum kernels as EmulatedNeonSpectrumKernels
+ * Uses the real intrinsics on ARM, and NeonEmulation.h everywhere else
+ */
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#else
+#include "NeonEmulation.h"
+#endif
+#define SPECTRUM_KERNELS_NEON
+#define SpectrumKernels EmulatedNeonSpectrumKernels
+#include "../audacity/SpectrumKernels.cpp"
@@ -0,0 +1,67 @@
+/*
+ * Batched structure-of-arrays FFT throughput for K = 1, 4 and 8 windows
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include "Bench.h"
+#include "../audacity/FFT.h"
+
+static const int SIZES[] = {1024, 2048, 4096, 8192};
+static const int BATCHES[] = {1, 4, 8};
+
+/**
+ * Compare single window transforms against batched ones
+ */
+void benchFftBatch() {
+    for (int size : SIZES) {
+        FFT fft(size);
+        int half = size / 2;
+        std::vector<float> input(size * MAX_FFT_BATCH);
+        for (int k = 0; k < MAX_FFT_BATCH; k++)
+            benchSine(input.data() + k * size, size, 100.0 * (k + 1), 48000, 0.5f);
+
+        // Baseline: one window at a time through apply()
+        std::vector<float> buffer(size), re(size), im(size);
+        int transforms = std::max(64, (1 << 22) / size);
+        BenchTimer singleTimer;
+        for (int t = 0; t < transforms; t++) {
+            fft.apply(input.data() + (t % MAX_FFT_BATCH) * size, re.data(), im.data(), buffer.data());
+            benchKeep(re[t % half]);
+        }
+        double singleRate = transforms / (singleTimer.elapsedNanos() / 1e9);
+        printf("%5d points  single   %9.0f windows/s\n", size, singleRate);
+
+        for (int batch : BATCHES) {
+            std::vector<float> soa(size * batch);
+            std::vector<float> bre((half + 1) * batch), bim((half + 1) * batch);
+            int rounds = std::max(8, transforms / batch);
+            BenchTimer batchTimer;
+            for (int r = 0; r < rounds; r++) {
+                // Include the transpose into SoA layout in the cost
+                for (int k = 0; k < batch; k++) {
+                    const float *src = input.data() + k * size;
+                    for (int j = 0; j < size; j++)
+                        soa[j * batch + k] = src[j];
+                }
+                fft.applyBatch(soa.data(), bre.data(), bim.data(), batch);
+                benchKeep(bre[r % half]);
+            }
+            double batchRate = (double) rounds * batch / (batchTimer.elapsedNanos() / 1e9);
+
+            // Check against the single window transform
+            double maxError = 0;
+            for (int k = 0; k < batch; k++) {
+                fft.apply(input.data() + k * size, re.data(), im.data(), buffer.data());
+                for (int i = 0; i <= half; i++) {
+                    maxError = std::max(maxError, (double) std::fabs(re[i] - bre[i * batch + k]));
+                    maxError = std::max(maxError, (double) std::fabs(im[i] - bim[i * batch + k]));
+                }
+            }
+            printf("%5d points  K = %d    %9.0f windows/s  %.2fx  max error %.2g\n",
+                   size, batch, batchRate, batchRate / singleRate, maxError);
+        }
+    }
+}
@@ -0,0 +1,137 @@
+/*
+ * Octave errors and cost of the autocorrelation, harmonic product and fused detectors
+ * on bass tones with weak fundamentals
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "Bench.h"
+#include "../PI.h"
+#include "../audacity/FrequencyReader.h"
+
+static const int RATES[] = {44100, 48000};
+static const float BUFFER_SECONDS = 0.2f;
+
+// E1 up to A4, the lowest ones below what a 48 kHz window can hold a period of
+static const double NOTES[] = {41.20, 46.25, 55.00, 61.74, 73.42, 82.41, 98.00, 110.0,
+                               146.8, 196.0, 329.6, 440.0};
+
+// Above a tenth of the sample rate, where the fifth harmonic is past the top of the spectrum
+static const double HIGH_NOTES[] = {4978.0, 5919.9, 7902.1};
+
+// Fundamental level relative to a 1/n harmonic series
+static const float FUNDAMENTALS[] = {1.0f, 0.1f};
+
+static const int HARMONICS = 8;
+
+static const struct {
+    const char *name;
+    FrequencyReader::Detector detector;
+} DETECTORS[] = {
+        {"autocorrelation", FrequencyReader::AUTOCORRELATION},
+        {"harmonic product", FrequencyReader::HARMONIC_PRODUCT},
+        {"fused", FrequencyReader::FUSED},
+};
+
+/**
+ * Generate a harmonic tone with a scaled fundamental
+ * @param out Output samples
+ * @param count Number of samples
+ * @param freq Fundamental in hertz
+ * @param sampleRate Sample rate
+ * @param fundamental Level of the fundamental relative to the 1/n series
+ */
+static void harmonicTone(float *out, int count, double freq, int sampleRate, float fundamental) {
+    std::fill(out, out + count, 0.0f);
+    for (int n = 1; n <= HARMONICS && freq * n < sampleRate / 2; n++) {
+        double amp = 0.3 / n * (n == 1 ? fundamental : 1);
+        double phase = 0.7 * n * n;
+        for (int i = 0; i < count; i++)
+            out[i] += (float) (amp * sin(2 * PI * freq * n * i / sampleRate + phase));
+    }
+}
+
+/**
+ * Compare the detectors over a range of bass and mid notes
+ */
+void benchHarmonicProduct() {
+    const int numNotes = sizeof(NOTES) / sizeof(NOTES[0]);
+    const int numDetectors = sizeof(DETECTORS) / sizeof(DETECTORS[0]);
+    for (int rate : RATES) {
+        int frames = (int) (BUFFER_SECONDS * rate);
+        WavData wav(1, frames, rate, new float[frames], true);
+        FrequencyReader reader(rate, 0.01f, std::make_shared<WorkerPool>(0));
+        printf("%d Hz, window %d (%.1f Hz bins, longest lag %.1f Hz)\n", rate,
+               reader.getWindowSize(), (double) rate / reader.getWindowSize(),
+               (double) rate / (reader.getWindowSize() / 2 - 1));
+
+        for (float fundamental : FUNDAMENTALS) {
+            // Signed error of each note per detector, for the per-note table
+            double errors[numDetectors][numNotes];
+            for (int d = 0; d < numDetectors; d++) {
+                reader.setDetector(DETECTORS[d].detector);
+                int octaveErrors = 0;
+                std::vector<double> cents;
+                double totalUs = 0;
+                for (int n = 0; n < numNotes; n++) {
+                    harmonicTone(wav.samples, frames, NOTES[n], rate, fundamental);
+                    const int queries = 10;
+                    float freq = 0;
+                    BenchTimer timer;
+                    for (int q = 0; q < queries; q++)
+                        freq = reader.getFrequency(&wav, 0, 0, frames);
+                    totalUs += timer.elapsedNanos() / queries / 1000;
+
+                    double error = freq > 0 ? 1200 * log2(freq / NOTES[n]) : 1e9;
+                    errors[d][n] = error;
+                    if (fabs(error) > 100)
+                        octaveErrors++;
+                    else
+                        cents.push_back(fabs(error));
+                }
+                std::sort(cents.begin(), cents.end());
+                double median = cents.empty() ? 0 : cents[cents.size() / 2];
+                printf("  fundamental %4.0f%%  %-16s  wrong notes %2d/%d  median error %5.2f cents  "
+                       "%7.1f us/query\n", fundamental * 100, DETECTORS[d].name, octaveErrors,
+                       numNotes, median, totalUs / numNotes);
+            }
+
+            // Error of each note in cents, or the interval when the note is wrong
+            printf("    %8s", "note");
+            for (const auto &d : DETECTORS)
+                printf("  %16s", d.name);
+            printf("\n");
+            for (int n = 0; n < numNotes; n++) {
+                printf("    %6.2f Hz", NOTES[n]);
+                for (int d = 0; d < numDetectors; d++) {
+                    double error = errors[d][n];
+                    if (error > 1e8)
+                        printf("  %16s", "none");
+                    else if (fabs(error) > 100)
+                        printf("  %10.0f wrong", error);
+                    else
+                        printf("  %+16.2f", error);
+                }
+                printf("\n");
+            }
+        }
+
+        // Where the harmonics don't fit, the fused detector keeps the autocorrelation lag
+        // (sine tones, as the engine's low pass leaves little above the top note)
+        printf("    %8s  %16s  %16s\n", "sine", DETECTORS[0].name, DETECTORS[2].name);
+        for (double note : HIGH_NOTES) {
+            benchSine(wav.samples, frames, note, rate, 0.5f);
+            printf("    %6.1f Hz", note);
+            for (int d : {0, 2}) {
+                reader.setDetector(DETECTORS[d].detector);
+                float freq = reader.getFrequency(&wav, 0, 0, frames);
+                if (freq > 0)
+                    printf("  %+16.2f", 1200 * log2(freq / note));
+                else
+                    printf("  %16s", "none");
+            }
+            printf("\n");
+        }
+    }
+}
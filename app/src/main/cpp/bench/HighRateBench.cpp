@@ -0,0 +1,119 @@
+/*
+ * Cost and accuracy of direct vs. decimated analysis at 96 and 192 kHz, and how far the
+ * single-precision FFT drifts from a double-precision one as transforms grow
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <vector>
+#include "Bench.h"
+#include "../PI.h"
+#include "../audacity/FrequencyReader.h"
+#include "../data/Decimator.h"
+
+static const int RATES[] = {96000, 192000};
+static const float BUFFER_SECONDS = 0.2f;
+static const double NOTES[] = {55.00, 82.41, 110.0, 146.8, 196.0, 246.9, 329.6,
+                               440.0, 659.3, 880.0, 1318.5};
+static const int FFT_SIZES[] = {2048, 4096, 8192, 16384, 32768};
+
+/**
+ * Time and check one way of analyzing a rate
+ * @param rate Input sample rate
+ * @param decimate True to decimate before the frequency reader
+ */
+static void analyze(int rate, bool decimate) {
+    int frames = (int) (BUFFER_SECONDS * rate);
+    std::vector<float> input(frames);
+    Decimator decimator(rate, decimate ? MIN_ANALYSIS_RATE : rate, frames);
+    int analysisRate = decimator.getOutputRate();
+    int analysisFrames = frames / decimator.getFactor();
+    WavData wav(1, analysisFrames, analysisRate, new float[analysisFrames], true);
+    FrequencyReader reader(analysisRate, 0.01f, std::make_shared<WorkerPool>(0));
+
+    std::vector<double> cents;
+    double totalUs = 0;
+    for (double note : NOTES) {
+        std::fill(input.begin(), input.end(), 0.0f);
+        for (int n = 1; n <= 4; n++) {
+            for (int i = 0; i < frames; i++)
+                input[i] += (float) (0.3 / n * sin(2 * PI * note * n * i / rate + n));
+        }
+
+        const int queries = 10;
+        float freq = 0;
+        BenchTimer timer;
+        for (int q = 0; q < queries; q++) {
+            decimator.apply(input.data(), frames, wav.samples);
+            freq = reader.getFrequency(&wav, 0, 0, wav.numFrames);
+        }
+        totalUs += timer.elapsedNanos() / queries / 1000;
+        cents.push_back(freq > 0 ? fabs(1200 * log2(freq / note)) : 1200);
+    }
+    std::sort(cents.begin(), cents.end());
+    int notes = sizeof(NOTES) / sizeof(NOTES[0]);
+    printf("%6d Hz  %-9s  analyzed at %6d Hz  window %5d  %7.1f us/query  "
+           "error median %5.2f max %6.2f cents\n", rate, decimate ? "decimated" : "direct",
+           analysisRate, reader.getWindowSize(), totalUs / notes, cents[notes / 2],
+           cents[notes - 1]);
+}
+
+/**
+ * Reference double-precision FFT
+ * @param data Input (replaced by the transform)
+ */
+static void referenceFft(std::vector<std::complex<double>> &data) {
+    int n = (int) data.size();
+    for (int i = 1, j = 0; i < n; i++) {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1)
+            j ^= bit;
+        j ^= bit;
+        if (i < j)
+            std::swap(data[i], data[j]);
+    }
+    for (int len = 2; len <= n; len <<= 1) {
+        std::complex<double> step = std::polar(1.0, -2 * PI / len);
+        for (int i = 0; i < n; i += len) {
+            std::complex<double> w = 1;
+            for (int j = 0; j < len / 2; j++, w *= step) {
+                std::complex<double> u = data[i + j], v = data[i + j + len / 2] * w;
+                data[i + j] = u + v;
+                data[i + j + len / 2] = u - v;
+            }
+        }
+    }
+}
+
+/**
+ * Compare both analysis paths and measure single-precision FFT error by size
+ */
+void benchHighRate() {
+    for (int rate : RATES) {
+        analyze(rate, false);
+        analyze(rate, true);
+    }
+
+    printf("single-precision FFT vs. double (noise input):\n");
+    for (int size : FFT_SIZES) {
+        FFT fft(size);
+        std::vector<float> input(size), re(size), im(size), buffer(size);
+        std::vector<std::complex<double>> reference(size);
+        unsigned int seed = 12345;
+        for (int i = 0; i < size; i++) {
+            seed = seed * 1664525u + 1013904223u;
+            input[i] = (float) ((seed >> 8) / 16777216.0 - 0.5);
+            reference[i] = input[i];
+        }
+        fft.apply(input.data(), re.data(), im.data(), buffer.data());
+        referenceFft(reference);
+
+        double error = 0, magnitude = 0;
+        for (int i = 0; i <= size / 2; i++) {
+            error += std::norm(std::complex<double>(re[i], im[i]) - reference[i]);
+            magnitude += std::norm(reference[i]);
+        }
+        printf("%6d points  relative error %.2g\n", size, sqrt(error / magnitude));
+    }
+}
@@ -0,0 +1,92 @@
+/*
+ * Float vs. 16-bit input path: callback cost, storage traffic and level scans
+ */
+
+#include <vector>
+#include "Bench.h"
+#include "../tuner/SampleBuffer.h"
+#include "../data/SampleKernels.h"
+
+static const int SAMPLE_RATE = 48000;
+static const int CAPACITY = SAMPLE_RATE / 5;
+static const int BURST = 192;
+static const int CALLBACKS = 200000;
+static const int QUERIES = 5000;
+
+/**
+ * Time the callback and query side of one sample buffer format
+ * @param format Storage format
+ * @param floats Input bursts as floats
+ * @param ints Input bursts as 16-bit samples
+ */
+static void benchFormat(SampleBuffer::Format format, const std::vector<float> &floats,
+                        const std::vector<int16_t> &ints) {
+    SampleBuffer buffer(CAPACITY, format);
+    int bursts = (int) floats.size() / BURST;
+    int bytes = format == SampleBuffer::INT16 ? (int) sizeof(int16_t) : (int) sizeof(float);
+    const char *name = format == SampleBuffer::INT16 ? "int16" : "float";
+
+    // Audio callback: the stream delivers samples in the same format they're stored in
+    BenchTimer callbackTimer;
+    for (int i = 0; i < CALLBACKS; i++) {
+        int b = i % bursts;
+        if (format == SampleBuffer::INT16)
+            buffer.addSamples(ints.data() + b * BURST, BURST);
+        else
+            buffer.addSamples(floats.data() + b * BURST, BURST);
+    }
+    double callbackNs = callbackTimer.elapsedNanos() / CALLBACKS;
+
+    // Analysis side: snapshot (and convert) the ring for filtering
+    std::vector<float> wav(CAPACITY);
+    BenchTimer queryTimer;
+    for (int i = 0; i < QUERIES; i++) {
+        buffer.getSamples(wav.data());
+        benchKeep(wav[i % CAPACITY]);
+    }
+    double queryNs = queryTimer.elapsedNanos() / QUERIES;
+
+    // Raw level scans over a buffer's worth of samples
+    BenchTimer peakTimer;
+    for (int i = 0; i < QUERIES; i++) {
+        if (format == SampleBuffer::INT16)
+            benchKeep(SampleKernels::peak(ints.data(), CAPACITY));
+        else
+            benchKeep(SampleKernels::peak(floats.data(), CAPACITY));
+    }
+    double peakNs = peakTimer.elapsedNanos() / QUERIES;
+
+    BenchTimer rmsTimer;
+    for (int i = 0; i < QUERIES; i++) {
+        if (format == SampleBuffer::INT16)
+            benchKeep(SampleKernels::sumSquares(ints.data(), CAPACITY));
+        else
+            benchKeep(SampleKernels::sumSquares(floats.data(), CAPACITY));
+    }
+    double rmsNs = rmsTimer.elapsedNanos() / QUERIES;
+
+    // Storage traffic at real time: each sample is written once by the callback
+    // and read once per snapshot, plus the float copy handed to the filter
+    double ringBytes = (double) CAPACITY * bytes;
+    printf("%-6s callback %7.1f ns/burst  ring %6.1f KB  stream %6.1f KB/s  "
+           "snapshot %7.2f us (%5.2f GB/s)  peak %6.2f us (%5.2f GB/s)  rms %6.2f us (%5.2f GB/s)\n",
+           name, callbackNs, ringBytes / 1024, (double) SAMPLE_RATE * bytes / 1024,
+           queryNs / 1000, (ringBytes + CAPACITY * sizeof(float)) / queryNs,
+           peakNs / 1000, ringBytes / peakNs, rmsNs / 1000, ringBytes / rmsNs);
+    printf("%-6s peak %.5f rms %.5f\n", name, buffer.getPeakAmplitude(), buffer.getRMS());
+}
+
+/**
+ * Compare the float and 16-bit input paths
+ */
+void benchInputFormat() {
+    // One second of a quiet A4 split into callback bursts
+    std::vector<float> floats(SAMPLE_RATE);
+    std::vector<int16_t> ints(SAMPLE_RATE);
+    benchSine(floats.data(), SAMPLE_RATE, 440, SAMPLE_RATE, 0.25f);
+    SampleKernels::toInt16(floats.data(), ints.data(), SAMPLE_RATE);
+
+    printf("capacity %d samples, %d frame bursts at %d Hz\n", CAPACITY, BURST, SAMPLE_RATE);
+    benchFormat(SampleBuffer::FLOAT, floats, ints);
+    benchFormat(SampleBuffer::INT16, floats, ints);
+}
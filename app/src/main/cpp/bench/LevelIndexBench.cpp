@@ -0,0 +1,112 @@
+/*
+ * Block summary index vs. linear scans for peak, RMS and waveform envelope queries
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "Bench.h"
+#include "../tuner/SampleBuffer.h"
+#include "../data/SampleKernels.h"
+
+static const int SAMPLE_RATE = 48000;
+static const int CAPACITY = SAMPLE_RATE / 5;
+static const int BURST = 173;
+static const int WINDOW = 2048;
+static const int WIDTHS[] = {128, 1080};
+static const int QUERIES = 2000;
+
+/**
+ * Compare summary queries against scanning a snapshot of the same samples
+ * @param format Storage format
+ */
+static void benchLevels(SampleBuffer::Format format) {
+    SampleBuffer buffer(CAPACITY, format);
+    const char *name = format == SampleBuffer::INT16 ? "int16" : "float";
+
+    // Fill with an odd burst size so blocks straddle callbacks and the ring wraps
+    std::vector<float> input(SAMPLE_RATE);
+    benchSine(input.data(), SAMPLE_RATE, 110, SAMPLE_RATE, 0.5f);
+    for (int i = 0; i < SAMPLE_RATE; i++)
+        input[i] *= (float) i / SAMPLE_RATE;
+    BenchTimer fillTimer;
+    int pos = 0;
+    for (int i = 0; i < 2000; i++) {
+        buffer.addSamples(input.data() + pos, BURST);
+        pos = (pos + BURST) % (SAMPLE_RATE - BURST);
+    }
+    double callbackNs = fillTimer.elapsedNanos() / 2000;
+
+    std::vector<float> snapshot(CAPACITY);
+    buffer.getSamples(snapshot.data());
+
+    // Peak per analysis window (the engine's silence pre-check)
+    double maxError = 0;
+    BenchTimer indexTimer;
+    for (int q = 0; q < QUERIES; q++)
+        for (int start = 0; start + WINDOW < CAPACITY; start += WINDOW)
+            benchKeep(buffer.getPeakAmplitude(start, WINDOW));
+    double indexNs = indexTimer.elapsedNanos() / QUERIES;
+
+    BenchTimer scanTimer;
+    for (int q = 0; q < QUERIES; q++)
+        for (int start = 0; start + WINDOW < CAPACITY; start += WINDOW)
+            benchKeep(SampleKernels::peak(snapshot.data() + start, WINDOW));
+    double scanNs = scanTimer.elapsedNanos() / QUERIES;
+
+    for (int start = 0; start + WINDOW < CAPACITY; start += WINDOW)
+        maxError = std::max(maxError, (double) std::fabs(buffer.getPeakAmplitude(start, WINDOW)
+                - SampleKernels::peak(snapshot.data() + start, WINDOW)));
+
+    // Whole buffer RMS
+    BenchTimer rmsIndexTimer;
+    for (int q = 0; q < QUERIES; q++)
+        benchKeep(buffer.getRMS());
+    double rmsIndexNs = rmsIndexTimer.elapsedNanos() / QUERIES;
+
+    BenchTimer rmsScanTimer;
+    for (int q = 0; q < QUERIES; q++)
+        benchKeep(sqrt(SampleKernels::sumSquares(snapshot.data(), CAPACITY) / CAPACITY));
+    double rmsScanNs = rmsScanTimer.elapsedNanos() / QUERIES;
+
+    double rmsScan = sqrt(SampleKernels::sumSquares(snapshot.data(), CAPACITY) / CAPACITY);
+    maxError = std::max(maxError, std::fabs(buffer.getRMS() - rmsScan));
+
+    printf("%-6s callback %6.1f ns/burst  window peaks %6.2f us (scan %6.2f us)  "
+           "rms %6.2f us (scan %6.2f us)  max error %.2g\n",
+           name, callbackNs, indexNs / 1000, scanNs / 1000, rmsIndexNs / 1000, rmsScanNs / 1000,
+           maxError);
+
+    // Waveform envelope at view widths vs. copying the raw buffer out and scanning it
+    for (int width : WIDTHS) {
+        std::vector<float> min(width), max(width), raw(CAPACITY);
+        BenchTimer envTimer;
+        for (int q = 0; q < QUERIES; q++) {
+            buffer.getEnvelope(min.data(), max.data(), width);
+            benchKeep(max[q % width]);
+        }
+        double envNs = envTimer.elapsedNanos() / QUERIES;
+
+        BenchTimer rawTimer;
+        for (int q = 0; q < QUERIES; q++) {
+            buffer.getSamples(raw.data());
+            for (int x = 0; x < width; x++) {
+                int s = x * CAPACITY / width, e = (x + 1) * CAPACITY / width;
+                SampleKernels::range(raw.data() + s, e - s, min[x], max[x]);
+            }
+            benchKeep(max[q % width]);
+        }
+        double rawNs = rawTimer.elapsedNanos() / QUERIES;
+        printf("%-6s envelope %4d columns %6.2f us (copy+scan %6.2f us)\n",
+               name, width, envNs / 1000, rawNs / 1000);
+    }
+}
+
+/**
+ * Compare indexed level queries with linear scans
+ */
+void benchLevelIndex() {
+    printf("capacity %d samples, %d frame windows\n", CAPACITY, WINDOW);
+    benchLevels(SampleBuffer::FLOAT);
+    benchLevels(SampleBuffer::INT16);
+}
@@ -0,0 +1,130 @@
+#ifndef TUNEBLOB_NEONEMULATION_H
+#define TUNEBLOB_NEONEMULATION_H
+
+/*
+ * Portable stand-ins for the NEON intrinsics the spectrum kernels use, following the lane
+ * semantics in the ARM intrinsics reference, so their NEON path can be run on x86 hosts.
+ * Only a check of the lane logic: timings and code generation mean nothing here.
+ */
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+struct float32x2_t { float v[2]; };
+struct float32x4_t { float v[4]; };
+struct float32x4x2_t { float32x4_t val[2]; };
+struct uint32x4_t { uint32_t v[4]; };
+
+inline float32x4_t vld1q_f32(const float *p) {
+    float32x4_t r;
+    memcpy(r.v, p, sizeof(r.v));
+    return r;
+}
+
+inline void vst1q_f32(float *p, float32x4_t a) {
+    memcpy(p, a.v, sizeof(a.v));
+}
+
+inline uint32x4_t vld1q_u32(const uint32_t *p) {
+    uint32x4_t r;
+    memcpy(r.v, p, sizeof(r.v));
+    return r;
+}
+
+inline void vst1q_u32(uint32_t *p, uint32x4_t a) {
+    memcpy(p, a.v, sizeof(a.v));
+}
+
+inline float32x4_t vdupq_n_f32(float x) {
+    return {{x, x, x, x}};
+}
+
+inline uint32x4_t vdupq_n_u32(uint32_t x) {
+    return {{x, x, x, x}};
+}
+
+inline float32x4_t vaddq_f32(float32x4_t a, float32x4_t b) {
+    for (int l = 0; l < 4; l++)
+        a.v[l] += b.v[l];
+    return a;
+}
+
+inline float32x4_t vsubq_f32(float32x4_t a, float32x4_t b) {
+    for (int l = 0; l < 4; l++)
+        a.v[l] -= b.v[l];
+    return a;
+}
+
+inline float32x4_t vmulq_f32(float32x4_t a, float32x4_t b) {
+    for (int l = 0; l < 4; l++)
+        a.v[l] *= b.v[l];
+    return a;
+}
+
+inline uint32x4_t vaddq_u32(uint32x4_t a, uint32x4_t b) {
+    for (int l = 0; l < 4; l++)
+        a.v[l] += b.v[l];
+    return a;
+}
+
+// FMAX: the larger value, and +0 over -0
+inline float32x4_t vmaxq_f32(float32x4_t a, float32x4_t b) {
+    for (int l = 0; l < 4; l++) {
+        if (a.v[l] == b.v[l])
+            a.v[l] = std::signbit(a.v[l]) ? b.v[l] : a.v[l];
+        else if (b.v[l] > a.v[l])
+            a.v[l] = b.v[l];
+    }
+    return a;
+}
+
+inline uint32x4_t vcgtq_f32(float32x4_t a, float32x4_t b) {
+    uint32x4_t r;
+    for (int l = 0; l < 4; l++)
+        r.v[l] = a.v[l] > b.v[l] ? 0xffffffffu : 0;
+    return r;
+}
+
+// Bitwise select: bits of a where the mask is set, of b elsewhere
+inline uint32x4_t vbslq_u32(uint32x4_t mask, uint32x4_t a, uint32x4_t b) {
+    for (int l = 0; l < 4; l++)
+        a.v[l] = (mask.v[l] & a.v[l]) | (~mask.v[l] & b.v[l]);
+    return a;
+}
+
+inline float32x4_t vbslq_f32(uint32x4_t mask, float32x4_t a, float32x4_t b) {
+    for (int l = 0; l < 4; l++) {
+        uint32_t x, y;
+        memcpy(&x, &a.v[l], 4);
+        memcpy(&y, &b.v[l], 4);
+        x = (mask.v[l] & x) | (~mask.v[l] & y);
+        memcpy(&a.v[l], &x, 4);
+    }
+    return a;
+}
+
+// {a0, b0, a1, b1}, {a2, b2, a3, b3}
+inline float32x4x2_t vzipq_f32(float32x4_t a, float32x4_t b) {
+    return {{{{a.v[0], b.v[0], a.v[1], b.v[1]}}, {{a.v[2], b.v[2], a.v[3], b.v[3]}}}};
+}
+
+// Reverses the lanes within each 64-bit half: {a1, a0, a3, a2}
+inline float32x4_t vrev64q_f32(float32x4_t a) {
+    return {{a.v[1], a.v[0], a.v[3], a.v[2]}};
+}
+
+inline float32x2_t vget_low_f32(float32x4_t a) {
+    return {{a.v[0], a.v[1]}};
+}
+
+inline float32x2_t vget_high_f32(float32x4_t a) {
+    return {{a.v[2], a.v[3]}};
+}
+
+inline float32x4_t vcombine_f32(float32x2_t low, float32x2_t high) {
+    return {{low.v[0], low.v[1], high.v[0], high.v[1]}};
+}
+
+
+#endif //TUNEBLOB_NEONEMULATION_H
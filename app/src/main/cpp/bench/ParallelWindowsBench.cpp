@@ -0,0 +1,60 @@
+/*
+ * Sequential vs. worker pool multi-window frequency detection at high sample rates
+ */
+
+#include <thread>
+#include <vector>
+#include "Bench.h"
+#include "../audacity/FrequencyReader.h"
+
+static const int RATES[] = {48000, 96000, 192000};
+static const float BUFFER_SECONDS[] = {0.2f, 0.5f};
+
+/**
+ * Time frequency queries with a given pool
+ * @param reader Frequency reader
+ * @param wav Input samples
+ * @param frequency Detected frequency output
+ * @return Time per query in microseconds
+ */
+static double timeQueries(FrequencyReader &reader, WavData &wav, float &frequency) {
+    const int queries = 20;
+    frequency = reader.getFrequency(&wav, 0, 0, wav.numFrames);
+    BenchTimer timer;
+    for (int q = 0; q < queries; q++)
+        benchKeep(reader.getFrequency(&wav, 0, 0, wav.numFrames));
+    return timer.elapsedNanos() / queries / 1000;
+}
+
+/**
+ * Compare sequential and parallel window processing
+ */
+void benchParallelWindows() {
+    auto sequential = std::make_shared<WorkerPool>(0);
+    auto shared = WorkerPool::getShared();
+    auto fixed = std::make_shared<WorkerPool>(MAX_SHARED_WORKERS);
+    printf("%u hardware threads, shared pool has %d workers, fixed pool has %d\n",
+           std::thread::hardware_concurrency(), shared->getNumWorkers(), fixed->getNumWorkers());
+
+    for (int rate : RATES) {
+        for (float seconds : BUFFER_SECONDS) {
+            int frames = (int) (seconds * rate);
+            WavData wav(1, frames, rate, new float[frames], true);
+            benchSine(wav.samples, frames, 196, rate, 0.5f);
+
+            FrequencyReader seqReader(rate, 0.01f, sequential);
+            FrequencyReader parReader(rate, 0.01f, shared);
+            FrequencyReader fixedReader(rate, 0.01f, fixed);
+            float seqFreq, parFreq, fixedFreq;
+            double seqUs = timeQueries(seqReader, wav, seqFreq);
+            double parUs = timeQueries(parReader, wav, parFreq);
+            double fixedUs = timeQueries(fixedReader, wav, fixedFreq);
+
+            printf("%6d Hz %.1f s  window %5d x %2d  sequential %8.1f us  shared %8.1f us (%.2fx)  "
+                   "fixed %8.1f us (%.2fx)  %.3f Hz %s\n",
+                   rate, seconds, seqReader.getWindowSize(), frames / seqReader.getWindowSize(),
+                   seqUs, parUs, seqUs / parUs, fixedUs, seqUs / fixedUs, parFreq,
+                   seqFreq == parFreq && seqFreq == fixedFreq ? "(identical)" : "(MISMATCH)");
+        }
+    }
+}
@@ -0,0 +1,176 @@
+/*
+ * High-rate pitch tracking of vibrato: the phase tracker anchored by the full detector at
+ * the engine's hop rate, against running the full detector at every tracking hop
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <vector>
+#include "Bench.h"
+#include "../PI.h"
+#include "../audacity/FrequencyReader.h"
+#include "../tuner/PhaseTracker.h"
+#include "../tuner/TunerInputEngine.h"
+#include "../input/SyntheticInputSource.h"
+
+static const int RATES[] = {44100, 48000};
+static const double SECONDS = 2;
+static const float BUFFER_SECONDS = 0.2f;
+
+// Vibrato around A3 and A4
+static const double NOTES[] = {220.0, 440.0};
+static const double VIBRATO_RATE = 6;
+static const double VIBRATO_CENTS = 30;
+
+/**
+ * Pitch of the vibrato tone at a time
+ * @param note Center frequency
+ * @param time Time in seconds
+ * @return Frequency in hertz
+ */
+static double vibratoPitch(double note, double time) {
+    return note * pow(2.0, VIBRATO_CENTS * sin(2 * PI * VIBRATO_RATE * time) / 1200);
+}
+
+/**
+ * Generate a vibrato tone with three harmonics
+ * @param out Output samples
+ * @param count Number of samples
+ * @param note Center frequency
+ * @param sampleRate Sample rate
+ */
+static void vibratoTone(float *out, int count, double note, int sampleRate) {
+    double phase = 0;
+    for (int i = 0; i < count; i++) {
+        double sample = 0;
+        for (int n = 1; n <= 3; n++)
+            sample += 0.3 / n * sin(n * phase);
+        out[i] = (float) sample;
+        phase += 2 * PI * vibratoPitch(note, (double) i / sampleRate) / sampleRate;
+    }
+}
+
+/**
+ * Error statistics of a pitch stream
+ */
+struct Errors {
+    std::vector<double> cents;
+
+    void add(float frequency, double expected) {
+        cents.push_back(frequency > 0 ? fabs(1200 * log2(frequency / expected)) : 1200);
+    }
+
+    double rms() const {
+        double sum = 0;
+        for (double c : cents)
+            sum += c * c;
+        return cents.empty() ? 0 : sqrt(sum / cents.size());
+    }
+};
+
+/**
+ * Track one note both ways
+ * @param rate Sample rate
+ * @param note Center frequency
+ */
+static void trackNote(int rate, double note) {
+    int frames = (int) (SECONDS * rate);
+    int bufferFrames = (int) (BUFFER_SECONDS * rate);
+    WavData wav(1, frames, rate, new float[frames], true);
+    vibratoTone(wav.samples, frames, note, rate);
+
+    FrequencyReader reader(rate, 0.01f, std::make_shared<WorkerPool>(0));
+    reader.setDetector(FrequencyReader::FUSED);
+    PhaseTracker tracker(rate, bufferFrames / 2);
+    PitchHistory history(HISTORY_CAPACITY);
+    int hop = tracker.getHopFrames();
+    int engineHop = reader.getWindowSize() / 2;
+
+    // Full detector on a single window ending at every tracking hop
+    int window = reader.getWindowSize();
+    Errors fullErrors;
+    BenchTimer fullTimer;
+    for (int end = bufferFrames; end <= frames - 1; end += hop) {
+        float freq = reader.getFrequency(&wav, 0, end - window, window);
+        fullErrors.add(freq, vibratoPitch(note, (end - window / 2.0) / rate));
+    }
+    double fullMs = fullTimer.elapsedNanos() / 1e6;
+
+    // Tracker anchored by the full detector over the engine's buffer at the engine's hop
+    Errors trackErrors;
+    PitchHistory::Entry entries[256];
+    int64_t since = 0;
+    double trackNs = 0;
+    for (int end = bufferFrames; end <= frames - 1; end += engineHop) {
+        BenchTimer timer;
+        float confidence;
+        float coarse = reader.getFrequency(&wav, 0, end - bufferFrames, bufferFrames, &confidence);
+        tracker.setReference(coarse, confidence);
+        tracker.process(wav.samples + end - bufferFrames, bufferFrames, end, history);
+        trackNs += timer.elapsedNanos();
+
+        // Each result covers two windows a hop apart
+        double lag = tracker.getWindowFrames() / 2.0 + hop / 2.0;
+        int count;
+        while ((count = history.fetch(since, entries, 256)) > 0)
+            for (int i = 0; i < count; i++)
+                trackErrors.add(entries[i].frequency,
+                                vibratoPitch(note, (entries[i].time * rate - lag) / rate));
+    }
+    double trackMs = trackNs / 1e6;
+
+    double audio = (double) (frames - bufferFrames) / rate;
+    printf("  %5.1f Hz  full detector %4.0f/s  %6.1f ms CPU/s  rms %5.2f cents   "
+           "tracker %4.0f/s  %5.1f ms CPU/s  rms %5.2f cents  (%.0fx cheaper)\n", note,
+           fullErrors.cents.size() / audio, fullMs / audio, fullErrors.rms(),
+           trackErrors.cents.size() / audio, trackMs / audio, trackErrors.rms(),
+           fullMs / trackMs);
+}
+
+/**
+ * Run the engine in tracking mode on a steady tone and check the result stream
+ */
+static void checkEngine() {
+    const int rate = 48000;
+    const double note = 196.0;
+    TunerInputEngine engine;
+    engine.setParameters(0.2f, 0.01f, 1000, false);
+    engine.setTracking(true);
+    auto source = std::make_shared<SyntheticInputSource>(rate, note, 0.5f, 3, 0.01f, 256, 4);
+    engine.start(source);
+    std::vector<PitchHistory::Entry> entries;
+    PitchHistory::Entry block[256];
+    int64_t since = 0;
+    BenchTimer timer;
+    while (timer.elapsedNanos() < 0.5e9) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        int count;
+        while ((count = engine.fetchHistory(since, block, 256)) > 0)
+            entries.insert(entries.end(), block, block + count);
+    }
+    engine.stop();
+    double audio = (double) source->getFramesDelivered() / rate - BUFFER_SECONDS;
+
+    Errors errors;
+    for (const PitchHistory::Entry &e : entries)
+        errors.add(e.frequency, note);
+    std::sort(errors.cents.begin(), errors.cents.end());
+    double median = errors.cents.empty() ? 0 : errors.cents[errors.cents.size() / 2];
+    printf("engine tracking mode, %.0f Hz tone at %d Hz: %.0f results/s, median error %.2f cents\n",
+           note, rate, entries.size() / audio, median);
+}
+
+/**
+ * Compare both ways of tracking vibrato at each rate
+ */
+void benchPhaseTrack() {
+    printf("vibrato %.0f Hz +-%.0f cents, tracking hop %.1f ms\n", VIBRATO_RATE, VIBRATO_CENTS,
+           TRACK_HOP_SECONDS * 1000);
+    for (int rate : RATES) {
+        printf("%d Hz\n", rate);
+        for (double note : NOTES)
+            trackNote(rate, note);
+    }
+    checkEngine();
+}
@@ -0,0 +1,117 @@
+/*
+ * Per-stage cost of the engine's analysis path (ring copy, low pass, frequency reader)
+ * and the memory traffic of each stage per analyzed sample, as counted by the loops
+ * themselves when built with -DTRAFFIC_COUNTERS=ON
+ */
+
+#include <cmath>
+#include <cstring>
+#include "Bench.h"
+#include "../audacity/FrequencyReader.h"
+#include "../biquad/BiQuadFilter.h"
+#include "../debug/TrafficCounter.h"
+#include "../tuner/SampleBuffer.h"
+
+static const int RATES[] = {44100, 48000};
+static const float BUFFER_SECONDS = 0.2f;
+static const int ROUNDS = 200;
+
+/**
+ * Print one stage
+ * @param name Stage name
+ * @param nanos Total time over all rounds
+ * @param bytes Bytes loaded and stored over all rounds
+ * @param frames Samples analyzed per round
+ */
+static void printStage(const char *name, double nanos, int64_t bytes, int frames) {
+    printf("  %-18s %8.1f us", name, nanos / ROUNDS / 1000);
+    if (TrafficCounter::isEnabled())
+        printf("  %7.1f bytes/sample", (double) bytes / ROUNDS / frames);
+    printf("\n");
+}
+
+/**
+ * Low pass one section at a time, each sweeping the whole buffer, as BiQuadFilter did
+ * before it ran the cascade on each sample in turn
+ * @param filter Filter whose sections are used
+ * @param wav Samples to filter in place
+ */
+static void lowPassBySection(BiQuadFilter &filter, WavData *wav) {
+    for (int p = 0; p < BiQuadFilter::EIGHT; p++) {
+        BiQuadPass pass;
+        filter.setupPass(pass, wav->sampleRate, POLE_BANDWIDTHS[BiQuadFilter::EIGHT - 1][p]);
+        for (int f = 0; f < wav->numFrames; f++)
+            wav->samples[f] = pass.transform(wav->samples[f]);
+        COUNT_TRAFFIC(2 * sizeof(float) * wav->numFrames);
+    }
+}
+
+/**
+ * Time each stage of the analysis path and count its traffic
+ * Traffic is every load and store of the loops on the path, FFT passes included, whether
+ * it hits in cache or not.
+ */
+void benchPipeline() {
+    if (!TrafficCounter::isEnabled())
+        printf("Built without TRAFFIC_COUNTERS - reconfigure with -DTRAFFIC_COUNTERS=ON for "
+               "traffic\n");
+    for (int rate : RATES) {
+        int frames = (int) (BUFFER_SECONDS * rate);
+        SampleBuffer ring(frames);
+        float *tone = new float[frames];
+        benchSine(tone, frames, 196, rate, 0.5f);
+        ring.addSamples(tone, frames);
+        delete[] tone;
+
+        WavData wav(1, frames, rate, new float[frames], true);
+        WavData reference(1, frames, rate, new float[frames], true);
+        BiQuadFilter lowPass(BiQuadFilter::LOW_PASS, BiQuadFilter::EIGHT, 1000);
+        FrequencyReader reader(rate, 0.01f, std::make_shared<WorkerPool>(0));
+        // Same detector as the engine, over the full window
+        reader.setDetector(FrequencyReader::FUSED);
+        int window = reader.getWindowSize();
+        int windows = frames / window;
+
+        double copyNanos = 0, filterNanos = 0, sectionNanos = 0, detectNanos = 0;
+        int64_t copyBytes = 0, filterBytes = 0, sectionBytes = 0, detectBytes = 0;
+        float frequency = 0;
+        for (int r = 0; r < ROUNDS; r++) {
+            TrafficCounter::reset();
+            BenchTimer copyTimer;
+            ring.getSamples(wav.samples);
+            copyNanos += copyTimer.elapsedNanos();
+            copyBytes += TrafficCounter::getBytes();
+
+            ring.getSamples(reference.samples);
+            TrafficCounter::reset();
+            BenchTimer sectionTimer;
+            lowPassBySection(lowPass, &reference);
+            sectionNanos += sectionTimer.elapsedNanos();
+            sectionBytes += TrafficCounter::getBytes();
+
+            TrafficCounter::reset();
+            BenchTimer filterTimer;
+            lowPass.apply(&wav);
+            filterNanos += filterTimer.elapsedNanos();
+            filterBytes += TrafficCounter::getBytes();
+
+            TrafficCounter::reset();
+            BenchTimer detectTimer;
+            frequency = reader.getFrequency(&wav, 0, 0, frames);
+            detectNanos += detectTimer.elapsedNanos();
+            detectBytes += TrafficCounter::getBytes();
+        }
+
+        printf("%d Hz, %d samples, window %d x %d -> %.2f Hz\n", rate, frames, window, windows,
+               frequency);
+        printStage("ring copy", copyNanos, copyBytes, frames);
+        printStage("low pass", filterNanos, filterBytes, frames);
+        printStage("  by section", sectionNanos, sectionBytes, frames);
+        printStage("frequency reader", detectNanos, detectBytes, frames);
+        printStage("total", copyNanos + filterNanos + detectNanos,
+                   copyBytes + filterBytes + detectBytes, frames);
+        bool same = memcmp(wav.samples, reference.samples, frames * sizeof(float)) == 0;
+        printf("  low pass by section is the pre-cascade reference (output %s)\n",
+               same ? "identical" : "DIFFERENT");
+    }
+}
@@ -0,0 +1,216 @@
+/*
+ * Cost of the FrequencyReader's work after the transforms (peak pruning, reversal, summing
+ * the windows and the argmax) per window size, scalar vs. the vectorized kernels, and a
+ * check that every kernel path gives the same results as the scalar build
+ * On an ARM build (or under qemu) the kernels of this build are the NEON ones.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include "Bench.h"
+#include "../PI.h"
+#include "ReferenceKernels.h"
+#include "../audacity/SpectrumKernels.h"
+
+static const int WINDOW_SIZES[] = {256, 512, 1024, 2048, 4096, 8192};
+static const int WINDOWS = 4;
+
+/**
+ * Scalar peak pruning, reversal and scaling as the reader did it before the kernels
+ * @param processed Autocorrelation values (modified)
+ * @param temp Temp array
+ * @param output Output spectrum
+ * @param half Number of lags
+ * @param scale Divisor
+ */
+static void prunePeaksScalar(float *processed, float *temp, float *output, int half, float scale) {
+    for (int i = 0; i < half; i++) {
+        if (processed[i] < 0.0)
+            processed[i] = 0;
+        temp[i] = processed[i];
+        if ((i % 2) == 0)
+            processed[i] -= temp[i / 2];
+        else
+            processed[i] -= ((temp[i / 2] + temp[i / 2 + 1]) / 2);
+        if (processed[i] < 0.0)
+            processed[i] = 0;
+    }
+    for (int i = 0; i < half; i++)
+        output[half - 1 - i] = processed[i] / scale;
+}
+
+/**
+ * Scalar sum of the window spectra and argmax as the reader did it before the kernels
+ * @param spectra Window spectra
+ * @param sum Summed spectrum
+ * @param half Values per spectrum
+ * @return Index of the peak
+ */
+static int sumArgmaxScalar(const float *spectra, float *sum, int half) {
+    memset(sum, 0, half * sizeof(float));
+    for (int w = 0; w < WINDOWS; w++)
+        for (int j = 0; j < half; j++)
+            sum[j] += spectra[w * half + j];
+    int argmax = 0;
+    for (int j = 1; j < half; j++)
+        if (sum[j] > sum[argmax])
+            argmax = j;
+    return argmax;
+}
+
+/**
+ * Sum of the window spectra and argmax with the kernels, as the reader does it now
+ * @param spectra Window spectra
+ * @param sum Summed spectrum
+ * @param half Values per spectrum
+ * @return Index of the peak
+ */
+template<typename Kernels>
+static int sumArgmaxKernels(const float *spectra, float *sum, int half) {
+    std::copy(spectra, spectra + half, sum);
+    for (int w = 1; w < WINDOWS - 1; w++)
+        Kernels::accumulate(sum, spectra + w * half, half);
+    return Kernels::accumulateArgmax(sum, spectra + (WINDOWS - 1) * half, half);
+}
+
+/**
+ * Check one kernel build against the scalar build on every length up to 64 and each window's
+ * lag count, with both signs, signed zeros and tied peaks in the input
+ * @param name Name of the build
+ * @return Number of cases that differ
+ */
+template<typename Kernels>
+static int checkKernels(const char *name) {
+    std::vector<int> counts;
+    for (int count = 1; count <= 64; count++)
+        counts.push_back(count);
+    for (int size : WINDOW_SIZES) {
+        counts.push_back(size / 2);
+        counts.push_back(size / 2 - 3);
+    }
+
+    int cases = 0, failures = 0;
+    uint32_t seed = 7;
+    for (int count : counts) {
+        std::vector<float> in(count), add(count);
+        for (int i = 0; i < count; i++) {
+            seed = seed * 1664525u + 1013904223u;
+            int kind = (seed >> 24) % 8;
+            float value = ((float) ((seed >> 4) & 0xfffff) / (1 << 20) - 0.5f) * 512;
+            in[i] = kind == 0 ? 0.0f : kind == 1 ? -0.0f : kind == 2 ? 100.0f : value;
+            add[i] = kind == 3 ? 0.0f : value * 0.25f;
+        }
+
+        // Bit for bit, so signed zeros count
+        std::vector<float> scalar(count), vector(count);
+        ScalarSpectrumKernels::prunePeaks(in.data(), scalar.data(), count, 0.25f);
+        Kernels::prunePeaks(in.data(), vector.data(), count, 0.25f);
+        failures += memcmp(scalar.data(), vector.data(), count * sizeof(float)) != 0;
+
+        std::vector<float> scalarSum(in), vectorSum(in);
+        ScalarSpectrumKernels::accumulate(scalarSum.data(), add.data(), count);
+        Kernels::accumulate(vectorSum.data(), add.data(), count);
+        failures += memcmp(scalarSum.data(), vectorSum.data(), count * sizeof(float)) != 0;
+
+        scalarSum = in;
+        vectorSum = in;
+        int scalarPeak = ScalarSpectrumKernels::accumulateArgmax(scalarSum.data(), add.data(), count);
+        int vectorPeak = Kernels::accumulateArgmax(vectorSum.data(), add.data(), count);
+        failures += scalarPeak != vectorPeak ||
+                memcmp(scalarSum.data(), vectorSum.data(), count * sizeof(float)) != 0;
+
+        failures += ScalarSpectrumKernels::argmax(in.data(), count) != Kernels::argmax(in.data(), count);
+        cases += 4;
+    }
+    printf("%-14s vs scalar build: %d/%d cases identical%s\n", name, cases - failures, cases,
+           failures > 0 ? "  DIFFERENT" : "");
+    return failures;
+}
+
+/**
+ * Time the post-processing of each window size
+ */
+void benchPostProcess() {
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    checkKernels<SpectrumKernels>("NEON");
+#elif defined(__SSE2__) || defined(_M_X64)
+    checkKernels<SpectrumKernels>("SSE2");
+    checkKernels<EmulatedNeonSpectrumKernels>("NEON emulated");
+#else
+    checkKernels<SpectrumKernels>("scalar");
+#endif
+
+    // The old code is the reader's loop before the kernels, and the scalar build is the same
+    // kernels with the vector code compiled out, which is what the speedup is measured against
+    printf("per window, old code / scalar build / kernels: prune + reverse + scale, then sum of "
+           "%d windows + argmax\n", WINDOWS);
+    for (int size : WINDOW_SIZES) {
+        int half = size / 2;
+        float scale = size / 4;
+
+        // Autocorrelation-like input: a decaying harmonic series with some noise, both signs
+        std::vector<float> input(half);
+        uint32_t seed = 1;
+        for (int i = 0; i < half; i++) {
+            seed = seed * 1664525u + 1013904223u;
+            float noise = ((float) (seed >> 8) / (1 << 24) - 0.5f) * 0.2f;
+            input[i] = (float) (cos(2 * PI * i / 97.3) + 0.5 * cos(4 * PI * i / 97.3)) *
+                       expf(-(float) i / half) * scale + noise * scale;
+        }
+
+        std::vector<float> processed(half), temp(half), oldOut(half), scalarOut(half), kernelOut(half);
+        int iterations = std::max(10, 4000000 / size);
+
+        BenchTimer oldTimer;
+        for (int n = 0; n < iterations; n++) {
+            std::copy(input.begin(), input.end(), processed.begin());
+            prunePeaksScalar(processed.data(), temp.data(), oldOut.data(), half, scale);
+        }
+        double oldNs = oldTimer.elapsedNanos() / iterations;
+
+        BenchTimer scalarTimer;
+        for (int n = 0; n < iterations; n++)
+            ScalarSpectrumKernels::prunePeaks(input.data(), scalarOut.data(), half, 1 / scale);
+        double scalarNs = scalarTimer.elapsedNanos() / iterations;
+
+        BenchTimer kernelTimer;
+        for (int n = 0; n < iterations; n++)
+            SpectrumKernels::prunePeaks(input.data(), kernelOut.data(), half, 1 / scale);
+        double kernelNs = kernelTimer.elapsedNanos() / iterations;
+        bool pruneSame = memcmp(oldOut.data(), kernelOut.data(), half * sizeof(float)) == 0;
+
+        // Each window gets a slightly shifted spectrum so the sum isn't trivial
+        std::vector<float> spectra(WINDOWS * half), sum(half);
+        for (int w = 0; w < WINDOWS; w++)
+            for (int j = 0; j < half; j++)
+                spectra[w * half + j] = oldOut[(j + w) % half];
+
+        int oldPeak = 0, kernelPeak = 0;
+        BenchTimer sumOldTimer;
+        for (int n = 0; n < iterations; n++)
+            oldPeak = sumArgmaxScalar(spectra.data(), sum.data(), half);
+        double sumOldNs = sumOldTimer.elapsedNanos() / iterations;
+        std::vector<float> oldSum(sum);
+
+        BenchTimer sumScalarTimer;
+        for (int n = 0; n < iterations; n++)
+            benchKeep(sumArgmaxKernels<ScalarSpectrumKernels>(spectra.data(), sum.data(), half));
+        double sumScalarNs = sumScalarTimer.elapsedNanos() / iterations;
+
+        BenchTimer sumKernelTimer;
+        for (int n = 0; n < iterations; n++)
+            kernelPeak = sumArgmaxKernels<SpectrumKernels>(spectra.data(), sum.data(), half);
+        double sumKernelNs = sumKernelTimer.elapsedNanos() / iterations;
+        bool sumSame = oldPeak == kernelPeak &&
+                memcmp(oldSum.data(), sum.data(), half * sizeof(float)) == 0;
+        benchKeep(kernelOut[half / 2] + scalarOut[half / 2] + sum[half / 2]);
+
+        printf("window %5d  prune %7.1f / %7.1f / %6.1f ns (%4.1fx) %-9s  "
+               "sum+argmax %7.1f / %7.1f / %6.1f ns (%4.1fx) %s\n", size,
+               oldNs, scalarNs, kernelNs, scalarNs / kernelNs,
+               pruneSame ? "identical" : "DIFFERENT", sumOldNs, sumScalarNs, sumKernelNs,
+               sumScalarNs / sumKernelNs, sumSame ? "identical" : "DIFFERENT");
+    }
+}
@@ -0,0 +1,69 @@
+/*
+ * Cost of the inverse (second) FFT of the enhanced autocorrelation: mirrored full
+ * transform vs the real-even transform of the half spectrum
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include "Bench.h"
+#include "../audacity/FFT.h"
+
+static const int SIZES[] = {1024, 2048, 4096, 8192};
+static const int BATCH = 4;
+
+/**
+ * Compare both ways of transforming a cube-rooted power spectrum back
+ */
+void benchRealEven() {
+    for (int size : SIZES) {
+        FFT fft(size);
+        FFT evenFft(size / 2);
+        int half = size / 2;
+
+        // Power spectrum rows 0 to half, in structure-of-arrays layout
+        std::vector<float> signal(size), re(size), im(size), buffer(size);
+        std::vector<float> power((half + 1) * BATCH);
+        for (int k = 0; k < BATCH; k++) {
+            benchSine(signal.data(), size, 110.0 * (k + 1), 48000, 0.5f);
+            fft.applyHalf(signal.data(), re.data(), im.data(), buffer.data());
+            for (int i = 0; i <= half; i++)
+                power[i * BATCH + k] = cbrtf(re[i] * re[i] + im[i] * im[i]);
+        }
+
+        std::vector<float> soa(size * BATCH);
+        std::vector<float> fullRe((half + 1) * BATCH), fullIm((half + 1) * BATCH);
+        std::vector<float> evenOut((half + 1) * BATCH);
+        std::vector<float> workRe((half / 2 + 1) * BATCH), workIm((half / 2 + 1) * BATCH);
+        int rounds = std::max(16, (1 << 24) / size);
+
+        // Baseline: mirror into the upper half and run the full size transform
+        BenchTimer fullTimer;
+        for (int r = 0; r < rounds; r++) {
+            memcpy(soa.data(), power.data(), power.size() * sizeof(float));
+            for (int i = half + 1; i < size; i++)
+                memcpy(soa.data() + i * BATCH, soa.data() + (size - i) * BATCH, BATCH * sizeof(float));
+            fft.applyBatch(soa.data(), fullRe.data(), fullIm.data(), BATCH);
+            benchKeep(fullRe[r % half]);
+        }
+        double fullNanos = fullTimer.elapsedNanos() / ((double) rounds * BATCH);
+
+        BenchTimer evenTimer;
+        for (int r = 0; r < rounds; r++) {
+            memcpy(soa.data(), power.data(), power.size() * sizeof(float));
+            evenFft.applyRealEven(soa.data(), evenOut.data(), workRe.data(), workIm.data(), BATCH);
+            benchKeep(evenOut[r % half]);
+        }
+        double evenNanos = evenTimer.elapsedNanos() / ((double) rounds * BATCH);
+
+        // Only the first half of the real part is used by the detector
+        double maxError = 0, maxValue = 0;
+        for (int i = 0; i < half * BATCH; i++) {
+            maxError = std::max(maxError, (double) std::fabs(fullRe[i] - evenOut[i]));
+            maxValue = std::max(maxValue, (double) std::fabs(fullRe[i]));
+        }
+        printf("%5d points  full %8.0f ns  real-even %8.0f ns  %.2fx  relative error %.2g\n",
+               size, fullNanos, evenNanos, fullNanos / evenNanos, maxError / maxValue);
+    }
+}
@@ -0,0 +1,82 @@
+/*
+ * Real-time safety check of the audio callback path (build with -DRT_GUARD=ON)
+ * Runs the engine on a synthetic source, whose thread marks each TunerInputEngine::onInput
+ * call real-time, while the analysis runs and this thread polls like the UI, then reports
+ * any violations
+ */
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Bench.h"
+#include "../debug/RealtimeGuard.h"
+#include "../tuner/TunerInputEngine.h"
+#include "../input/SyntheticInputSource.h"
+
+static const int SAMPLE_RATE = 48000;
+static const int BURST = 192;
+static const float SPEED = 10;
+static const double SECONDS = 2;
+
+/**
+ * Run the engine's callback path for a format and count violations
+ * @param format Sample format the source delivers
+ */
+static void checkCallbackPath(SampleBuffer::Format format) {
+    TunerInputEngine engine;
+    engine.setParameters(0.2f, 0.01f, 1000, format == SampleBuffer::INT16);
+    auto source = std::make_shared<SyntheticInputSource>(SAMPLE_RATE, 196, 0.5f, 3, 0.01f,
+                                                         BURST, SPEED);
+
+    RealtimeGuard::resetViolations();
+    engine.start(source);
+
+    // Poll everything the UI reads, so the callback runs against the same contention
+    std::vector<float> waveform(SAMPLE_RATE);
+    std::vector<float> strobe(STROBE_CAPACITY);
+    PitchHistory::Entry entries[64];
+    int64_t sequence = 0, strobeSince = 0, historySince = 0;
+    BenchTimer timer;
+    while (timer.elapsedNanos() < SECONDS * 1e9) {
+        engine.getWaveform(sequence, waveform.data(), (int) waveform.size());
+        engine.fetchStrobe(strobeSince, strobe.data(), (int) strobe.size());
+        while (engine.fetchHistory(historySince, entries, 64) > 0) {
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(16));
+    }
+    engine.stop();
+
+    printf("%-5s  %lld callbacks  %lld analyses  violations: %lld allocation  %lld lock  "
+           "%lld blocking\n", format == SampleBuffer::INT16 ? "int16" : "float",
+           (long long) (source->getFramesDelivered() / BURST), (long long) engine.getAnalyzedHops(),
+           (long long) RealtimeGuard::getViolations(RealtimeGuard::ALLOCATION),
+           (long long) RealtimeGuard::getViolations(RealtimeGuard::LOCK),
+           (long long) RealtimeGuard::getViolations(RealtimeGuard::BLOCKING_CALL));
+}
+
+/**
+ * Check the callback path, then make sure the hooks actually catch a violation
+ */
+void benchRealtimeGuard() {
+    if (!RealtimeGuard::isEnabled()) {
+        printf("Built without RT_GUARD - reconfigure with -DRT_GUARD=ON\n");
+        return;
+    }
+
+    checkCallbackPath(SampleBuffer::FLOAT);
+    checkCallbackPath(SampleBuffer::INT16);
+
+    // Self test: an allocation and a lock inside a real-time scope must be counted
+    RealtimeGuard::resetViolations();
+    std::mutex mutex;
+    {
+        RealtimeScope realtime;
+        auto *leak = new std::vector<float>(16);
+        delete leak;
+        std::lock_guard<std::mutex> guard(mutex);
+    }
+    printf("self test: %lld allocation  %lld lock violations (expected at least 2 and 1)\n",
+           (long long) RealtimeGuard::getViolations(RealtimeGuard::ALLOCATION),
+           (long long) RealtimeGuard::getViolations(RealtimeGuard::LOCK));
+}
@@ -0,0 +1,39 @@
+#ifndef TUNEBLOB_REFERENCEKERNELS_H
+#define TUNEBLOB_REFERENCEKERNELS_H
+
+/**
+ * The spectrum kernels built again with one path forced, to check this build's kernels
+ * against: ScalarSpectrumKernels has the vector code compiled out, and
+ * EmulatedNeonSpectrumKernels runs the NEON code through NeonEmulation.h on hosts without
+ * NEON. Declared exactly like SpectrumKernels.
+ */
+class ScalarSpectrumKernels {
+public:
+
+    static void prunePeaks(const float *in, float *out, int count, float scale);
+    static void accumulate(float *sum, const float *add, int count);
+    static int accumulateArgmax(float *sum, const float *add, int count);
+    static int argmax(const float *values, int count);
+
+private:
+
+    template<bool Accumulate> static int scanMax(float *values, const float *add, int count);
+
+};
+
+class EmulatedNeonSpectrumKernels {
+public:
+
+    static void prunePeaks(const float *in, float *out, int count, float scale);
+    static void accumulate(float *sum, const float *add, int count);
+    static int accumulateArgmax(float *sum, const float *add, int count);
+    static int argmax(const float *values, int count);
+
+private:
+
+    template<bool Accumulate> static int scanMax(float *values, const float *add, int count);
+
+};
+
+
+#endif //TUNEBLOB_REFERENCEKERNELS_H
@@ -0,0 +1,7 @@
+/*
+ * The spectrum kernels with the vector code compiled out, as ScalarSpectrumKernels
+ */
+
+#define SPECTRUM_KERNELS_SCALAR
+#define SpectrumKernels ScalarSpectrumKernels
+#include "../audacity/SpectrumKernels.cpp"
@@ -0,0 +1,186 @@
+/*
+ * Headless load test of the full engine pipeline (buffering, gating, filtering, detection)
+ * Runs many engines on synthetic sources faster than real time to find how many real-time
+ * streams the analysis scheduler can sustain per core
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "Bench.h"
+#include "../tuner/TunerInputEngine.h"
+#include "../input/FileInputSource.h"
+#include "../input/SyntheticInputSource.h"
+#include "../thread/CoreBudget.h"
+
+static const int SAMPLE_RATE = 48000;
+static const float SPEED = 4;
+static const double RUN_SECONDS = 1.5;
+static const int STREAMS[] = {1, 2, 4, 8, 12, 16, 24, 32, 48};
+
+// A stream is sustained if at least this share of its hops got analyzed (or skipped on purpose)
+// (some slack for scheduling hiccups, which lose several hops at a time faster than real time)
+static const double SUSTAINED_RATIO = 0.9;
+
+/**
+ * Fetch and count the results an engine has recorded
+ * @param engine Engine
+ * @param since Sequence number to fetch from (updated)
+ * @param frequencies Detected frequencies are added here if not null
+ * @return Number of results fetched
+ */
+static int drainHistory(TunerInputEngine &engine, int64_t &since, std::vector<float> *frequencies) {
+    PitchHistory::Entry entries[256];
+    int total = 0, count;
+    while ((count = engine.fetchHistory(since, entries, 256)) > 0) {
+        total += count;
+        if (frequencies != nullptr)
+            for (int i = 0; i < count; i++)
+                frequencies->push_back(entries[i].frequency);
+    }
+    return total;
+}
+
+/**
+ * Run a number of streams at SPEED times real time
+ * @param numStreams Number of engines
+ * @param hop Frames between analyses
+ * @param cpuSeconds Process CPU time used
+ * @return Share of hops that were analyzed or skipped for a steady pitch (worst stream)
+ */
+static double runStreams(int numStreams, int hop, double &cpuSeconds) {
+    std::vector<std::shared_ptr<TunerInputEngine>> engines;
+    std::vector<std::shared_ptr<SyntheticInputSource>> sources;
+    std::vector<int64_t> since(numStreams, 0);
+    std::vector<int64_t> results(numStreams, 0);
+
+    for (int i = 0; i < numStreams; i++) {
+        auto engine = std::make_shared<TunerInputEngine>();
+        engine->setParameters(0.2f, 0.01f, 1000, false);
+        auto source = std::make_shared<SyntheticInputSource>(
+                SAMPLE_RATE, 110.0 * pow(2.0, i / 12.0), 0.5f, 3, 0.01f, 256, SPEED);
+        engines.push_back(engine);
+        sources.push_back(source);
+    }
+
+    std::clock_t cpuStart = std::clock();
+    for (int i = 0; i < numStreams; i++)
+        engines[i]->start(sources[i]);
+
+    BenchTimer timer;
+    while (timer.elapsedNanos() < RUN_SECONDS * 1e9) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        for (int i = 0; i < numStreams; i++)
+            results[i] += drainHistory(*engines[i], since[i], nullptr);
+    }
+
+    double worst = 1;
+    for (int i = 0; i < numStreams; i++) {
+        engines[i]->stop();
+        results[i] += drainHistory(*engines[i], since[i], nullptr) + engines[i]->getSkippedHops();
+
+        // The first results only come once the buffer has filled
+        int64_t frames = sources[i]->getFramesDelivered() - SAMPLE_RATE / 5;
+        double expected = std::max(1.0, (double) frames / hop);
+        worst = std::min(worst, results[i] / expected);
+    }
+    cpuSeconds = (double) (std::clock() - cpuStart) / CLOCKS_PER_SEC;
+    return worst;
+}
+
+/**
+ * Write a mono 16-bit WAV file
+ * @param path File path
+ * @param samples Samples
+ * @param count Number of samples
+ * @return True if written
+ */
+static bool writeWav(const char *path, const float *samples, int count) {
+    FILE *file = fopen(path, "wb");
+    if (file == nullptr)
+        return false;
+    auto put32 = [file](uint32_t v) { uint8_t b[4] = {(uint8_t) v, (uint8_t) (v >> 8), (uint8_t) (v >> 16), (uint8_t) (v >> 24)}; fwrite(b, 1, 4, file); };
+    auto put16 = [file](uint16_t v) { uint8_t b[2] = {(uint8_t) v, (uint8_t) (v >> 8)}; fwrite(b, 1, 2, file); };
+    fwrite("RIFF", 1, 4, file);
+    put32(36 + count * 2);
+    fwrite("WAVEfmt ", 1, 8, file);
+    put32(16);
+    put16(1);
+    put16(1);
+    put32(SAMPLE_RATE);
+    put32(SAMPLE_RATE * 2);
+    put16(2);
+    put16(16);
+    fwrite("data", 1, 4, file);
+    put32(count * 2);
+    for (int i = 0; i < count; i++)
+        put16((uint16_t) (int16_t) (samples[i] * 32767));
+    fclose(file);
+    return true;
+}
+
+/**
+ * Play a WAV file through the engine and check the detected pitch
+ */
+static void checkFileSource() {
+    const char *path = "/tmp/tuner_bench_330.wav";
+    std::vector<float> tone(SAMPLE_RATE * 2);
+    benchSine(tone.data(), (int) tone.size(), 330, SAMPLE_RATE, 0.5f);
+    if (!writeWav(path, tone.data(), (int) tone.size())) {
+        printf("file source: couldn't write %s\n", path);
+        return;
+    }
+
+    TunerInputEngine engine;
+    engine.setParameters(0.2f, 0.01f, 1000, false);
+    auto source = std::make_shared<FileInputSource>(path, 256, SPEED);
+    if (engine.start(source) != 0) {
+        printf("file source: failed to open %s\n", path);
+        return;
+    }
+    while (!source->isFinished())
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    engine.stop();
+
+    std::vector<float> frequencies;
+    int64_t since = 0;
+    drainHistory(engine, since, &frequencies);
+    std::sort(frequencies.begin(), frequencies.end());
+    float median = frequencies.empty() ? 0 : frequencies[frequencies.size() / 2];
+    printf("file source: 2 s WAV at 330 Hz -> %d results, median %.2f Hz\n",
+           (int) frequencies.size(), median);
+    remove(path);
+}
+
+/**
+ * Find the number of streams the scheduler sustains
+ */
+void benchStreamLoad() {
+    checkFileSource();
+
+    int hop = FrequencyReader(SAMPLE_RATE, 0.01f).getWindowSize() / 2;
+    int threads = AnalysisScheduler::getShared()->getNumThreads();
+    printf("%d big cores = %d scheduler threads + %d pool workers, %d Hz, hop %d frames, "
+           "sources at %.0fx real time\n", CoreBudget::countBigCores(), threads,
+           WorkerPool::getShared()->getNumWorkers() - 1, SAMPLE_RATE, hop, SPEED);
+
+    int sustained = 0;
+    double cpuPerStream = 0;
+    for (int streams : STREAMS) {
+        double cpuSeconds;
+        double ratio = runStreams(streams, hop, cpuSeconds);
+        double realtimeStreams = streams * SPEED;
+        double cpu = cpuSeconds / (RUN_SECONDS * realtimeStreams) * 100;
+        printf("%3d engines = %4.0f real-time streams  covered %5.1f%% of hops  CPU %.2f%% per stream\n",
+               streams, realtimeStreams, ratio * 100, cpu);
+        if (ratio < SUSTAINED_RATIO)
+            break;
+        sustained = (int) realtimeStreams;
+        cpuPerStream = cpu;
+    }
+    printf("sustained %d real-time streams = %.0f per scheduler thread (CPU cost predicts %.0f per core)\n",
+           sustained, (double) sustained / threads, cpuPerStream > 0 ? 100 / cpuPerStream : 0.0);
+}
@@ -0,0 +1,96 @@
+/*
+ * Strobe phase tracking precision (cents read back from the phase drift) and cost per sample
+ */
+
+#include <cmath>
+#include <vector>
+#include "Bench.h"
+#include "../PI.h"
+#include "../tuner/StrobeEngine.h"
+
+static const int SAMPLE_RATE = 48000;
+static const int BLOCK_FRAMES = 256;
+static const float SECONDS = 2.0f;
+static const float REFERENCES[] = {41.20f, 110.0f, 440.0f, 1318.5f};
+static const double DETUNE_CENTS[] = {0.0, 0.1, 0.5, -1.0, 5.0};
+
+/**
+ * Measure the detuning from the strobe phase of each harmonic
+ * @param reference Reference frequency in hertz
+ * @param cents Actual detuning in cents
+ * @param noise Noise amplitude
+ * @param errors Worst error in cents of any harmonic (updated)
+ * @return Nanoseconds of processing per sample
+ */
+static double track(float reference, double cents, float noise, double &errors) {
+    int frames = (int) (SECONDS * SAMPLE_RATE);
+    double freq = reference * pow(2.0, cents / 1200);
+    std::vector<float> input(frames);
+    unsigned int seed = 1;
+    for (int i = 0; i < frames; i++) {
+        double x = 0;
+        for (int n = 1; n <= STROBE_HARMONICS; n++)
+            x += 0.4 / n * sin(2 * PI * freq * n * i / SAMPLE_RATE + n);
+        seed = seed * 1664525u + 1013904223u;
+        input[i] = (float) (x + noise * ((seed >> 8) / 8388608.0 - 1));
+    }
+
+    StrobeEngine strobe(SAMPLE_RATE, (int) (STROBE_MAX_FRAME_RATE * SECONDS) + 1);
+    strobe.setReference(reference);
+    BenchTimer timer;
+    for (int i = 0; i + BLOCK_FRAMES <= frames; i += BLOCK_FRAMES)
+        strobe.process(input.data() + i, BLOCK_FRAMES);
+    double nanos = timer.elapsedNanos() / frames;
+
+    // Fit the unwrapped phase of each harmonic over time (skipping the first frame)
+    int64_t since = 0;
+    std::vector<float> out(strobe.getFrameRate() * SECONDS * STROBE_FRAME_VALUES + STROBE_FRAME_VALUES);
+    int count = strobe.fetch(since, out.data(), (int) (out.size() / STROBE_FRAME_VALUES));
+    for (int h = 0; h < STROBE_HARMONICS; h++) {
+        double unwrapped = 0, previous = out[STROBE_FRAME_VALUES + h * 2];
+        double sx = 0, sy = 0, sxx = 0, sxy = 0;
+        int n = 0;
+        for (int f = 1; f < count; f++) {
+            double p = out[f * STROBE_FRAME_VALUES + h * 2];
+            double d = p - previous;
+            unwrapped += d - 2 * PI * floor((d + PI) / (2 * PI));
+            previous = p;
+            double t = f / strobe.getFrameRate();
+            sx += t; sy += unwrapped; sxx += t * t; sxy += t * unwrapped;
+            n++;
+        }
+        double slope = (n * sxy - sx * sy) / (n * sxx - sx * sx);
+        double measured = 1200 * log2(1 + slope / (2 * PI * reference * (h + 1)));
+        errors = std::max(errors, fabs(measured - cents));
+    }
+    return nanos;
+}
+
+/**
+ * Check how precisely small detunings can be read back from the strobe phases
+ */
+void benchStrobe() {
+    printf("%d harmonics, %d Hz, %.0f s per run, error is the worst over detunings of",
+           STROBE_HARMONICS, SAMPLE_RATE, SECONDS);
+    for (double cents : DETUNE_CENTS)
+        printf(" %+.1f", cents);
+    printf(" cents\n");
+
+    for (float reference : REFERENCES) {
+        // The frame rate is set once the audio side picks up the reference
+        StrobeEngine probe(SAMPLE_RATE, 1);
+        probe.setReference(reference);
+        float dummy = 0;
+        probe.process(&dummy, 1);
+
+        double cleanError = 0, noisyError = 0, nanos = 0;
+        for (double cents : DETUNE_CENTS) {
+            nanos += track(reference, cents, 0, cleanError);
+            track(reference, cents, 0.3f, noisyError);
+        }
+        int runs = sizeof(DETUNE_CENTS) / sizeof(DETUNE_CENTS[0]);
+        printf("%7.2f Hz  %5.0f frames/s  clean error %.4f cents  noisy error %.4f cents  "
+               "%.1f ns/sample\n", reference, probe.getFrameRate(), cleanError, noisyError,
+               nanos / runs);
+    }
+}
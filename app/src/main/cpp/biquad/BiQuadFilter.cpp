@@ -1,5 +1,7 @@
+#include <cmath>
 #include <iostream>
 #include "BiQuadFilter.h"
+#include "../debug/TrafficCounter.h"
 #include "../PI.h"
 
 /**
@@ -10,34 +12,45 @@
  */
 BiQuadFilter::BiQuadFilter(PassType type, PoleType pole, double cutoffFrequency)
 : type(type), pole(pole), cutoffFrequency(cutoffFrequency) {
-    pass = std::make_shared<BiQuadPass>();
 }
 
 /**
  * Apply the biquad filter to a set of samples
+ * Every pass runs on each sample before moving to the next one, so the buffer is only read
+ * and written once and the passes overlap instead of waiting on each other. The result is
+ * the same as filtering the whole buffer once per pass.
  * @param wav Wav containing sample data
  */
 void BiQuadFilter::apply(WavData *wav) {
+
+    // Coefficients only change with the sample rate
+    if (wav->sampleRate != passRate) {
+        for (int p = 0; p < pole; p++)
+            setupPass(passes[p], wav->sampleRate, POLE_BANDWIDTHS[pole - 1][p]);
+        passRate = wav->sampleRate;
+    }
+
     int totalFrames = wav->numFrames * wav->channels;
-    for (int p = 0; p < pole; p++) {
-        setupPass(wav->sampleRate, POLE_BANDWIDTHS[pole - 1][p]);
-        for (int c = 0; c < wav->channels; c++) {
-            pass->reset();
-            for (int f = c; f < totalFrames; f += wav->channels) {
-                float input = wav->samples[f];
-                float output = pass->transform(input);
-                wav->samples[f] = output;
-            }
+    for (int c = 0; c < wav->channels; c++) {
+        for (int p = 0; p < pole; p++)
+            passes[p].reset();
+        for (int f = c; f < totalFrames; f += wav->channels) {
+            float sample = wav->samples[f];
+            for (int p = 0; p < pole; p++)
+                sample = passes[p].transform(sample);
+            wav->samples[f] = sample;
         }
     }
+    COUNT_TRAFFIC(2 * sizeof(float) * totalFrames);
 }
 
 /**
- * Setup the filter for the next pass
+ * Setup the coefficients of one pass
+ * @param pass Pass to set up
  * @param sampleRate Sample rate
  * @param bandwidth Pole bandwidth
  */
-void BiQuadFilter::setupPass(int sampleRate, double bandwidth) {
+void BiQuadFilter::setupPass(BiQuadPass &pass, int sampleRate, double bandwidth) {
     double w0 = 2 * PI * cutoffFrequency / sampleRate;
     double cosw0 = cos(w0);
     double alpha = sin(w0) / (2 * bandwidth);
@@ -62,5 +75,5 @@ void BiQuadFilter::setupPass(int sampleRate, double bandwidth) {
             return;
     }
 
-    pass->setCoefficients(aa0, aa1, aa2, b0, b1, b2);
+    pass.setCoefficients(aa0, aa1, aa2, b0, b1, b2);
 }
\ No newline at end of file
@@ -32,14 +32,15 @@ public:
     BiQuadFilter(PassType type, PoleType pole, double cutoffFrequency);
 
     void apply(WavData *wav);
-    void setupPass(int sampleRate, double bandwidth);
+    void setupPass(BiQuadPass &pass, int sampleRate, double bandwidth);
 
 protected:
 
     const PassType type;
     const PoleType pole;
     const double cutoffFrequency;
-    std::shared_ptr<BiQuadPass> pass;
+    BiQuadPass passes[EIGHT];
+    int passRate = 0;
 
 };
 
@@ -9,7 +9,7 @@ class BiQuadPass {
 public:
 
     void setCoefficients(double aa0, double aa1, double aa2, double b0, double b1, double b2);
-    float transform(float inSample);
+    inline float transform(float inSample);
     void reset();
 
 private:
@@ -29,5 +29,27 @@ private:
 
 };
 
+/**
+ * Transforms a sample using the biquad filter
+ * Defined here so BiQuadFilter's per-sample pass loop can inline it
+ * @param inSample Input sample
+ * @return Output sample
+ */
+float BiQuadPass::transform(float inSample) {
+
+    // Compute result
+    double result = a0 * inSample + a1 * x1 + a2 * x2 - a3 * y1 - a4 * y2;
+
+    // Shift x1 to x2, sample to x1
+    x2 = x1;
+    x1 = inSample;
+
+    // Shift y1 to y2, result to y1
+    y2 = y1;
+    y1 = result;
+
+    return (float) y1;
+}
+
 
 #endif //TUNEBLOB_BIQUADPASS_H
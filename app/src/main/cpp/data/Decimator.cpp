@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <cmath>
+#include "Decimator.h"
+#include "../PI.h"
+
+/**
+ * Create a decimator
+ * @param sampleRate Input sample rate
+ * @param minOutputRate Keep halving the rate while it stays at or above this
+ * @param maxFrames Largest number of input frames passed to apply()
+ */
+Decimator::Decimator(int sampleRate, int minOutputRate, int maxFrames) {
+    factor = 1;
+    while (sampleRate / (factor * 2) >= minOutputRate)
+        factor *= 2;
+    outputRate = sampleRate / factor;
+
+    // Odd taps of a Blackman windowed sinc at a quarter of the rate (the even ones are zero)
+    int half = HALF_BAND_TAPS / 2;
+    taps = new float[half / 2 + 1];
+    double sum = 0;
+    for (int k = 1; k <= half; k += 2) {
+        double x = PI * k / 2;
+        double w = 0.42 + 0.5 * cos(PI * k / (half + 1)) + 0.08 * cos(2 * PI * k / (half + 1));
+        taps[k / 2] = (float) (0.5 * sin(x) / x * w);
+        sum += 2 * taps[k / 2];
+    }
+
+    // Unity gain at DC (the center tap is 0.5)
+    for (int k = 1; k <= half; k += 2)
+        taps[k / 2] *= (float) (0.5 / sum);
+
+    // Intermediate stages alternate between the two halves of the work area
+    this->maxFrames = maxFrames;
+    temp = factor > 2 ? new float[maxFrames / 2 + maxFrames / 4] : nullptr;
+}
+
+Decimator::~Decimator() {
+    delete[] taps;
+    delete[] temp;
+}
+
+/**
+ * Decimate a block of samples
+ * The block is filtered on its own (zero outside of it), so the first and last few output
+ * samples are slightly off
+ * @param in Input samples
+ * @param numFrames Number of input samples (at most maxFrames)
+ * @param out Output samples (numFrames / factor of them)
+ * @return Number of output samples
+ */
+int Decimator::apply(const float *in, int numFrames, float *out) const {
+    if (factor == 1) {
+        std::copy(in, in + numFrames, out);
+        return numFrames;
+    }
+
+    // Only the last stage writes to the output
+    const float *src = in;
+    int stage = 0;
+    for (int f = factor; f > 1; f /= 2, stage++) {
+        float *dst = f == 2 ? out : temp + (stage % 2 == 1 ? maxFrames / 2 : 0);
+        numFrames = halve(src, numFrames, dst);
+        src = dst;
+    }
+    return numFrames;
+}
+
+/**
+ * Low pass a block at a quarter of its rate and drop every other sample
+ * @param in Input samples
+ * @param numFrames Number of input samples
+ * @param out Output samples (must not overlap the input)
+ * @return Number of output samples
+ */
+int Decimator::halve(const float *in, int numFrames, float *out) const {
+    int half = HALF_BAND_TAPS / 2;
+    int outFrames = numFrames / 2;
+    for (int i = 0; i < outFrames; i++) {
+        int center = i * 2;
+        float sum = 0.5f * in[center];
+        if (center >= half && center + half < numFrames) {
+            for (int k = 1; k <= half; k += 2)
+                sum += taps[k / 2] * (in[center - k] + in[center + k]);
+        } else {
+            // Edges of the block
+            for (int k = 1; k <= half; k += 2) {
+                if (center - k >= 0)
+                    sum += taps[k / 2] * in[center - k];
+                if (center + k < numFrames)
+                    sum += taps[k / 2] * in[center + k];
+            }
+        }
+        out[i] = sum;
+    }
+    return outFrames;
+}
+
+/**
+ * Get how much the sample rate is reduced by
+ * @return Decimation factor (1 if the input rate is already low enough)
+ */
+int Decimator::getFactor() const {
+    return factor;
+}
+
+/**
+ * Get the sample rate after decimation
+ * @return Output sample rate
+ */
+int Decimator::getOutputRate() const {
+    return outputRate;
+}
@@ -0,0 +1,41 @@
+#ifndef TUNEBLOB_DECIMATOR_H
+#define TUNEBLOB_DECIMATOR_H
+
+/**
+ * Reduces the sample rate by a power of two in half-band stages
+ * Each stage low passes at a quarter of its input rate and keeps every other sample, so
+ * 96 and 192 kHz input can be analyzed at 48 kHz (or 88.2/176.4 kHz at 44.1 kHz)
+ */
+class Decimator {
+public:
+
+    Decimator(int sampleRate, int minOutputRate, int maxFrames);
+    ~Decimator();
+
+    int apply(const float *in, int numFrames, float *out) const;
+    int getFactor() const;
+    int getOutputRate() const;
+
+private:
+
+    int halve(const float *in, int numFrames, float *out) const;
+
+    int factor;
+    int outputRate;
+    int maxFrames;
+    float *taps;
+    float *temp;
+};
+
+/**
+ * Length of the half-band filter (every other tap besides the center is zero)
+ */
+static const int HALF_BAND_TAPS = 31;
+
+/**
+ * Lowest rate high sample rate input is decimated to before analysis
+ */
+static const int MIN_ANALYSIS_RATE = 44100;
+
+
+#endif //TUNEBLOB_DECIMATOR_H
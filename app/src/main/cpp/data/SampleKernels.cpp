@@ -0,0 +1,335 @@
+#include <algorithm>
+#include <cmath>
+#include "SampleKernels.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SAMPLE_KERNELS_NEON
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SAMPLE_KERNELS_SSE2
+#endif
+
+/**
+ * Get the peak absolute value of a set of float samples
+ * @param samples Sample array
+ * @param count Number of samples
+ * @return Peak amplitude
+ */
+float SampleKernels::peak(const float *samples, int count) {
+    int i = 0;
+    float max = 0;
+#if defined(SAMPLE_KERNELS_NEON)
+    float32x4_t m0 = vdupq_n_f32(0), m1 = vdupq_n_f32(0);
+    for (; i + 8 <= count; i += 8) {
+        m0 = vmaxq_f32(m0, vabsq_f32(vld1q_f32(samples + i)));
+        m1 = vmaxq_f32(m1, vabsq_f32(vld1q_f32(samples + i + 4)));
+    }
+    float lanes[4];
+    vst1q_f32(lanes, vmaxq_f32(m0, m1));
+    max = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+#elif defined(SAMPLE_KERNELS_SSE2)
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    __m128 m0 = _mm_setzero_ps(), m1 = _mm_setzero_ps();
+    for (; i + 8 <= count; i += 8) {
+        m0 = _mm_max_ps(m0, _mm_and_ps(_mm_loadu_ps(samples + i), absMask));
+        m1 = _mm_max_ps(m1, _mm_and_ps(_mm_loadu_ps(samples + i + 4), absMask));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, _mm_max_ps(m0, m1));
+    max = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+#endif
+    for (; i < count; i++) {
+        float amp = std::fabs(samples[i]);
+        if (amp > max) max = amp;
+    }
+    return max;
+}
+
+/**
+ * Get the peak absolute value of a set of 16-bit samples
+ * -32768 saturates to 32767
+ * @param samples Sample array
+ * @param count Number of samples
+ * @return Peak amplitude
+ */
+int16_t SampleKernels::peak(const int16_t *samples, int count) {
+    int i = 0;
+    int max = 0;
+#if defined(SAMPLE_KERNELS_NEON)
+    int16x8_t m0 = vdupq_n_s16(0), m1 = vdupq_n_s16(0);
+    for (; i + 16 <= count; i += 16) {
+        m0 = vmaxq_s16(m0, vqabsq_s16(vld1q_s16(samples + i)));
+        m1 = vmaxq_s16(m1, vqabsq_s16(vld1q_s16(samples + i + 8)));
+    }
+    int16_t lanes[8];
+    vst1q_s16(lanes, vmaxq_s16(m0, m1));
+    for (int l = 0; l < 8; l++)
+        max = std::max(max, (int) lanes[l]);
+#elif defined(SAMPLE_KERNELS_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    __m128i m0 = zero, m1 = zero;
+    for (; i + 16 <= count; i += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i *) (samples + i));
+        __m128i b = _mm_loadu_si128((const __m128i *) (samples + i + 8));
+        // |x| = max(x, -x) using a saturating negate
+        m0 = _mm_max_epi16(m0, _mm_max_epi16(a, _mm_subs_epi16(zero, a)));
+        m1 = _mm_max_epi16(m1, _mm_max_epi16(b, _mm_subs_epi16(zero, b)));
+    }
+    int16_t lanes[8];
+    _mm_storeu_si128((__m128i *) lanes, _mm_max_epi16(m0, m1));
+    for (int l = 0; l < 8; l++)
+        max = std::max(max, (int) lanes[l]);
+#endif
+    for (; i < count; i++) {
+        int amp = std::abs((int) samples[i]);
+        if (amp > max) max = amp;
+    }
+    return (int16_t) std::min(max, 32767);
+}
+
+/**
+ * Get the minimum and maximum of a set of float samples
+ * @param samples Sample array
+ * @param count Number of samples (must be at least 1)
+ * @param min Minimum value output
+ * @param max Maximum value output
+ */
+void SampleKernels::range(const float *samples, int count, float &min, float &max) {
+    int i = 0;
+    float lo = samples[0], hi = samples[0];
+#if defined(SAMPLE_KERNELS_NEON)
+    if (count >= 4) {
+        float32x4_t vMin = vld1q_f32(samples), vMax = vMin;
+        for (i = 4; i + 4 <= count; i += 4) {
+            float32x4_t a = vld1q_f32(samples + i);
+            vMin = vminq_f32(vMin, a);
+            vMax = vmaxq_f32(vMax, a);
+        }
+        float lanesMin[4], lanesMax[4];
+        vst1q_f32(lanesMin, vMin);
+        vst1q_f32(lanesMax, vMax);
+        for (int l = 0; l < 4; l++) {
+            lo = std::min(lo, lanesMin[l]);
+            hi = std::max(hi, lanesMax[l]);
+        }
+    }
+#elif defined(SAMPLE_KERNELS_SSE2)
+    if (count >= 4) {
+        __m128 vMin = _mm_loadu_ps(samples), vMax = vMin;
+        for (i = 4; i + 4 <= count; i += 4) {
+            __m128 a = _mm_loadu_ps(samples + i);
+            vMin = _mm_min_ps(vMin, a);
+            vMax = _mm_max_ps(vMax, a);
+        }
+        float lanesMin[4], lanesMax[4];
+        _mm_storeu_ps(lanesMin, vMin);
+        _mm_storeu_ps(lanesMax, vMax);
+        for (int l = 0; l < 4; l++) {
+            lo = std::min(lo, lanesMin[l]);
+            hi = std::max(hi, lanesMax[l]);
+        }
+    }
+#endif
+    for (; i < count; i++) {
+        lo = std::min(lo, samples[i]);
+        hi = std::max(hi, samples[i]);
+    }
+    min = lo;
+    max = hi;
+}
+
+/**
+ * Get the minimum and maximum of a set of 16-bit samples
+ * @param samples Sample array
+ * @param count Number of samples (must be at least 1)
+ * @param min Minimum value output
+ * @param max Maximum value output
+ */
+void SampleKernels::range(const int16_t *samples, int count, int16_t &min, int16_t &max) {
+    int i = 0;
+    int16_t lo = samples[0], hi = samples[0];
+#if defined(SAMPLE_KERNELS_NEON)
+    if (count >= 8) {
+        int16x8_t vMin = vld1q_s16(samples), vMax = vMin;
+        for (i = 8; i + 8 <= count; i += 8) {
+            int16x8_t a = vld1q_s16(samples + i);
+            vMin = vminq_s16(vMin, a);
+            vMax = vmaxq_s16(vMax, a);
+        }
+        int16_t lanesMin[8], lanesMax[8];
+        vst1q_s16(lanesMin, vMin);
+        vst1q_s16(lanesMax, vMax);
+        for (int l = 0; l < 8; l++) {
+            lo = std::min(lo, lanesMin[l]);
+            hi = std::max(hi, lanesMax[l]);
+        }
+    }
+#elif defined(SAMPLE_KERNELS_SSE2)
+    if (count >= 8) {
+        __m128i vMin = _mm_loadu_si128((const __m128i *) samples), vMax = vMin;
+        for (i = 8; i + 8 <= count; i += 8) {
+            __m128i a = _mm_loadu_si128((const __m128i *) (samples + i));
+            vMin = _mm_min_epi16(vMin, a);
+            vMax = _mm_max_epi16(vMax, a);
+        }
+        int16_t lanesMin[8], lanesMax[8];
+        _mm_storeu_si128((__m128i *) lanesMin, vMin);
+        _mm_storeu_si128((__m128i *) lanesMax, vMax);
+        for (int l = 0; l < 8; l++) {
+            lo = std::min(lo, lanesMin[l]);
+            hi = std::max(hi, lanesMax[l]);
+        }
+    }
+#endif
+    for (; i < count; i++) {
+        lo = std::min(lo, samples[i]);
+        hi = std::max(hi, samples[i]);
+    }
+    min = lo;
+    max = hi;
+}
+
+/**
+ * Get the sum of squares of a set of float samples (for RMS levels)
+ * @param samples Sample array
+ * @param count Number of samples
+ * @return Sum of squares
+ */
+double SampleKernels::sumSquares(const float *samples, int count) {
+    int i = 0;
+    double sum = 0;
+#if defined(SAMPLE_KERNELS_NEON)
+    float32x4_t s0 = vdupq_n_f32(0), s1 = vdupq_n_f32(0);
+    for (; i + 8 <= count; i += 8) {
+        float32x4_t a = vld1q_f32(samples + i);
+        float32x4_t b = vld1q_f32(samples + i + 4);
+        s0 = vmlaq_f32(s0, a, a);
+        s1 = vmlaq_f32(s1, b, b);
+    }
+    float lanes[4];
+    vst1q_f32(lanes, vaddq_f32(s0, s1));
+    sum = (double) lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#elif defined(SAMPLE_KERNELS_SSE2)
+    __m128 s0 = _mm_setzero_ps(), s1 = _mm_setzero_ps();
+    for (; i + 8 <= count; i += 8) {
+        __m128 a = _mm_loadu_ps(samples + i);
+        __m128 b = _mm_loadu_ps(samples + i + 4);
+        s0 = _mm_add_ps(s0, _mm_mul_ps(a, a));
+        s1 = _mm_add_ps(s1, _mm_mul_ps(b, b));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, _mm_add_ps(s0, s1));
+    sum = (double) lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+    for (; i < count; i++)
+        sum += samples[i] * samples[i];
+    return sum;
+}
+
+/**
+ * Get the sum of squares of a set of 16-bit samples in float scale (for RMS levels)
+ * Accumulates exactly in 64-bit integers before scaling
+ * @param samples Sample array
+ * @param count Number of samples
+ * @return Sum of squares (as if the samples were floats from -1 to 1)
+ */
+double SampleKernels::sumSquares(const int16_t *samples, int count) {
+    int i = 0;
+    uint64_t sum = 0;
+#if defined(SAMPLE_KERNELS_NEON)
+    int64x2_t acc = vdupq_n_s64(0);
+    for (; i + 8 <= count; i += 8) {
+        int16x8_t a = vld1q_s16(samples + i);
+        acc = vpadalq_s32(acc, vmull_s16(vget_low_s16(a), vget_low_s16(a)));
+        acc = vpadalq_s32(acc, vmull_s16(vget_high_s16(a), vget_high_s16(a)));
+    }
+    sum = (uint64_t) (vgetq_lane_s64(acc, 0) + vgetq_lane_s64(acc, 1));
+#elif defined(SAMPLE_KERNELS_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc = zero;
+    for (; i + 8 <= count; i += 8) {
+        __m128i a = _mm_loadu_si128((const __m128i *) (samples + i));
+        // Pair sums peak at 2^31, so widen them as unsigned
+        __m128i sq = _mm_madd_epi16(a, a);
+        acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(sq, zero));
+        acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(sq, zero));
+    }
+    uint64_t lanes[2];
+    _mm_storeu_si128((__m128i *) lanes, acc);
+    sum = lanes[0] + lanes[1];
+#endif
+    for (; i < count; i++)
+        sum += (uint64_t) ((int) samples[i] * (int) samples[i]);
+    return (double) sum / ((double) INT16_SCALE * INT16_SCALE);
+}
+
+/**
+ * Convert 16-bit samples to floats from -1 to 1
+ * @param in Input samples
+ * @param out Output samples
+ * @param count Number of samples
+ */
+void SampleKernels::toFloat(const int16_t *in, float *out, int count) {
+    int i = 0;
+    const float scale = 1.0f / INT16_SCALE;
+#if defined(SAMPLE_KERNELS_NEON)
+    const float32x4_t vScale = vdupq_n_f32(scale);
+    for (; i + 8 <= count; i += 8) {
+        int16x8_t a = vld1q_s16(in + i);
+        vst1q_f32(out + i, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(a))), vScale));
+        vst1q_f32(out + i + 4, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(a))), vScale));
+    }
+#elif defined(SAMPLE_KERNELS_SSE2)
+    const __m128 vScale = _mm_set1_ps(scale);
+    for (; i + 8 <= count; i += 8) {
+        __m128i a = _mm_loadu_si128((const __m128i *) (in + i));
+        // Sign extend by shifting each sample into the high half of a 32-bit lane
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(a, a), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(a, a), 16);
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), vScale));
+        _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), vScale));
+    }
+#endif
+    for (; i < count; i++)
+        out[i] = (float) in[i] * scale;
+}
+
+/**
+ * Convert floats from -1 to 1 to 16-bit samples (saturating)
+ * Every path clamps first and then rounds to nearest with ties to even (the default
+ * rounding mode), so ARM, x86 and the scalar tail all give the same samples.
+ * @param in Input samples
+ * @param out Output samples
+ * @param count Number of samples
+ */
+void SampleKernels::toInt16(const float *in, int16_t *out, int count) {
+    int i = 0;
+#if defined(SAMPLE_KERNELS_NEON)
+    // Adding and subtracting 1.5 * 2^23 leaves the clamped value rounded to an integer, which
+    // converts exactly (32-bit NEON has no round to nearest conversion)
+    const float32x4_t vScale = vdupq_n_f32(INT16_SCALE);
+    const float32x4_t vMin = vdupq_n_f32(-32768.0f), vMax = vdupq_n_f32(32767.0f);
+    const float32x4_t vRound = vdupq_n_f32(12582912.0f);
+    for (; i + 8 <= count; i += 8) {
+        float32x4_t a = vminq_f32(vmaxq_f32(vmulq_f32(vld1q_f32(in + i), vScale), vMin), vMax);
+        float32x4_t b = vminq_f32(vmaxq_f32(vmulq_f32(vld1q_f32(in + i + 4), vScale), vMin), vMax);
+        int32x4_t lo = vcvtq_s32_f32(vsubq_f32(vaddq_f32(a, vRound), vRound));
+        int32x4_t hi = vcvtq_s32_f32(vsubq_f32(vaddq_f32(b, vRound), vRound));
+        vst1q_s16(out + i, vcombine_s16(vmovn_s32(lo), vmovn_s32(hi)));
+    }
+#elif defined(SAMPLE_KERNELS_SSE2)
+    const __m128 vScale = _mm_set1_ps(INT16_SCALE);
+    const __m128 vMin = _mm_set1_ps(-32768.0f), vMax = _mm_set1_ps(32767.0f);
+    for (; i + 8 <= count; i += 8) {
+        __m128 a = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(in + i), vScale), vMin), vMax);
+        __m128 b = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(in + i + 4), vScale), vMin), vMax);
+        __m128i packed = _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b));
+        _mm_storeu_si128((__m128i *) (out + i), packed);
+    }
+#endif
+    for (; i < count; i++) {
+        float s = std::max(-32768.0f, std::min(32767.0f, in[i] * INT16_SCALE));
+        out[i] = (int16_t) lrintf(s);
+    }
+}
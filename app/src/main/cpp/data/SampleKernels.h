@@ -0,0 +1,33 @@
+#ifndef TUNEBLOB_SAMPLEKERNELS_H
+#define TUNEBLOB_SAMPLEKERNELS_H
+
+#include <cstdint>
+
+/**
+ * Vectorized scans and conversions over raw sample arrays
+ * Uses NEON on ARM and SSE2 on x86, with a scalar fallback for everything else
+ */
+class SampleKernels {
+public:
+
+    static float peak(const float *samples, int count);
+    static int16_t peak(const int16_t *samples, int count);
+
+    static void range(const float *samples, int count, float &min, float &max);
+    static void range(const int16_t *samples, int count, int16_t &min, int16_t &max);
+
+    static double sumSquares(const float *samples, int count);
+    static double sumSquares(const int16_t *samples, int count);
+
+    static void toFloat(const int16_t *in, float *out, int count);
+    static void toInt16(const float *in, int16_t *out, int count);
+
+};
+
+/**
+ * Scale between 16-bit integer and floating point samples
+ */
+static const float INT16_SCALE = 32768.0f;
+
+
+#endif //TUNEBLOB_SAMPLEKERNELS_H
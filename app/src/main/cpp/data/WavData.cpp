@@ -1,5 +1,7 @@
 #include <cstdlib>
 #include "WavData.h"
+#include "SampleKernels.h"
+#include "../debug/TrafficCounter.h"
 
 /**
  * Initialize WAV data
@@ -18,7 +20,7 @@ WavData::WavData(int channels, int numFrames, int sampleRate, float *samples, co
  */
 WavData::~WavData() {
     if (freeSamples)
-        delete samples;
+        delete[] samples;
 }
 
 /**
@@ -28,12 +30,6 @@ WavData::~WavData() {
  * @return Peak amplitude (absolute value)
  */
 float WavData::getPeakAmplitude(int startFrame, int numFrames) const {
-    float max = 0;
-    startFrame *= channels;
-    int endFrame = startFrame + numFrames * channels;
-    for (int i = startFrame; i < endFrame; i++) {
-        float amp = fabs(samples[i]);
-        if (amp > max) max = amp;
-    }
-    return max;
+    COUNT_TRAFFIC(sizeof(float) * numFrames * channels);
+    return SampleKernels::peak(samples + startFrame * channels, numFrames * channels);
 }
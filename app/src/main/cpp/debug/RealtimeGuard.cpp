@@ -0,0 +1,258 @@
+#include <atomic>
+#include <cstdlib>
+#include <pthread.h>
+#include <poll.h>
+#include <semaphore.h>
+#include <time.h>
+#include <unistd.h>
+#include "RealtimeGuard.h"
+#include "../logging_macros.h"
+
+/**
+ * Per-thread real-time flag
+ * A pthread key is used instead of thread_local since the first access to thread_local
+ * storage can allocate, which would recurse into the allocation hooks
+ */
+static pthread_key_t realtimeKey;
+static bool keyCreated = pthread_key_create(&realtimeKey, nullptr) == 0;
+
+static std::atomic<int64_t> violations[RealtimeGuard::NUM_VIOLATIONS];
+
+static const char *VIOLATION_NAMES[RealtimeGuard::NUM_VIOLATIONS] = {
+        "allocation", "lock", "blocking call"
+};
+
+/**
+ * Check if the checks were compiled in
+ * @return True if built with RT_GUARD
+ */
+bool RealtimeGuard::isEnabled() {
+#ifdef RT_GUARD
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * Mark the current thread as real-time
+ */
+void RealtimeGuard::enter() {
+    if (keyCreated)
+        pthread_setspecific(realtimeKey, &realtimeKey);
+}
+
+/**
+ * Clear the real-time mark from the current thread
+ */
+void RealtimeGuard::leave() {
+    if (keyCreated)
+        pthread_setspecific(realtimeKey, nullptr);
+}
+
+/**
+ * Check if the current thread is marked as real-time
+ * @return True if real-time
+ */
+bool RealtimeGuard::isRealtime() {
+    return keyCreated && pthread_getspecific(realtimeKey) != nullptr;
+}
+
+/**
+ * Record a call, which is a violation if the current thread is real-time
+ * @param type Kind of call
+ * @param call Name of the function that was called
+ */
+void RealtimeGuard::check(Violation type, const char *call) {
+    if (!isRealtime())
+        return;
+    violations[type]++;
+#ifdef RT_GUARD_ABORT
+    // Logging may allocate, so leave real-time mode first
+    leave();
+    LOGF("Real-time violation: %s (%s)", VIOLATION_NAMES[type], call);
+    abort();
+#else
+    (void) call;
+#endif
+}
+
+/**
+ * Get the number of violations of a kind
+ * @param type Kind of violation
+ * @return Number of violations since the last reset
+ */
+int64_t RealtimeGuard::getViolations(Violation type) {
+    return violations[type];
+}
+
+/**
+ * Get the number of violations of any kind
+ * @return Number of violations since the last reset
+ */
+int64_t RealtimeGuard::getTotalViolations() {
+    int64_t total = 0;
+    for (auto &count : violations)
+        total += count;
+    return total;
+}
+
+/**
+ * Reset all violation counts
+ */
+void RealtimeGuard::resetViolations() {
+    for (auto &count : violations)
+        count = 0;
+}
+
+/**
+ * Log the violation counts if there were any
+ */
+void RealtimeGuard::report() {
+    if (getTotalViolations() == 0)
+        return;
+    for (int i = 0; i < NUM_VIOLATIONS; i++)
+        LOGW("Real-time violations (%s): %lld", VIOLATION_NAMES[i],
+             (long long) getViolations((Violation) i));
+}
+
+#ifdef RT_GUARD
+
+// operator new takes a size_t, which is mangled differently on 32 and 64-bit targets
+#if defined(__LP64__)
+#define NEW_SYMBOL(prefix) prefix##_Znwm
+#define NEW_ARRAY_SYMBOL(prefix) prefix##_Znam
+#else
+#define NEW_SYMBOL(prefix) prefix##_Znwj
+#define NEW_ARRAY_SYMBOL(prefix) prefix##_Znaj
+#endif
+
+/*
+ * Linker wrappers (-Wl,--wrap=<symbol>) for every call that isn't real-time safe
+ * Each one records the call and forwards it to the real implementation.
+ */
+extern "C" {
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+void *NEW_SYMBOL(__real_)(size_t size);
+void *NEW_ARRAY_SYMBOL(__real_)(size_t size);
+void __real__ZdlPv(void *ptr);
+void __real__ZdaPv(void *ptr);
+int __real_pthread_mutex_lock(pthread_mutex_t *mutex);
+int __real_pthread_cond_wait(pthread_cond_t *cond, pthread_mutex_t *mutex);
+int __real_sem_wait(sem_t *sem);
+int __real_usleep(useconds_t usec);
+int __real_nanosleep(const struct timespec *req, struct timespec *rem);
+ssize_t __real_read(int fd, void *buf, size_t count);
+ssize_t __real_write(int fd, const void *buf, size_t count);
+int __real_poll(struct pollfd *fds, nfds_t nfds, int timeout);
+#ifdef __ANDROID__
+void __real__ZNSt6__ndk15mutex4lockEv(void *mutex);
+void __real__ZNSt6__ndk118condition_variable4waitERNS_11unique_lockINS_5mutexEEE(void *cond,
+                                                                                 void *lock);
+#endif
+
+void *__wrap_malloc(size_t size) {
+    RealtimeGuard::check(RealtimeGuard::ALLOCATION, "malloc");
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+    RealtimeGuard::check(RealtimeGuard::ALLOCATION, "calloc");
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    RealtimeGuard::check(RealtimeGuard::ALLOCATION, "realloc");
+    return __real_realloc(ptr, size);
+}
+
+void __wrap_free(void *ptr) {
+    RealtimeGuard::check(RealtimeGuard::ALLOCATION, "free");
+    __real_free(ptr);
+}
+
+void *NEW_SYMBOL(__wrap_)(size_t size) {
+    RealtimeGuard::check(RealtimeGuard::ALLOCATION, "operator new");
+    return NEW_SYMBOL(__real_)(size);
+}
+
+void *NEW_ARRAY_SYMBOL(__wrap_)(size_t size) {
+    RealtimeGuard::check(RealtimeGuard::ALLOCATION, "operator new[]");
+    return NEW_ARRAY_SYMBOL(__real_)(size);
+}
+
+void __wrap__ZdlPv(void *ptr) {
+    RealtimeGuard::check(RealtimeGuard::ALLOCATION, "operator delete");
+    __real__ZdlPv(ptr);
+}
+
+void __wrap__ZdaPv(void *ptr) {
+    RealtimeGuard::check(RealtimeGuard::ALLOCATION, "operator delete[]");
+    __real__ZdaPv(ptr);
+}
+
+int __wrap_pthread_mutex_lock(pthread_mutex_t *mutex) {
+    RealtimeGuard::check(RealtimeGuard::LOCK, "pthread_mutex_lock");
+    return __real_pthread_mutex_lock(mutex);
+}
+
+int __wrap_pthread_cond_wait(pthread_cond_t *cond, pthread_mutex_t *mutex) {
+    RealtimeGuard::check(RealtimeGuard::LOCK, "pthread_cond_wait");
+    return __real_pthread_cond_wait(cond, mutex);
+}
+
+int __wrap_sem_wait(sem_t *sem) {
+    RealtimeGuard::check(RealtimeGuard::LOCK, "sem_wait");
+    return __real_sem_wait(sem);
+}
+
+int __wrap_usleep(useconds_t usec) {
+    RealtimeGuard::check(RealtimeGuard::BLOCKING_CALL, "usleep");
+    return __real_usleep(usec);
+}
+
+int __wrap_nanosleep(const struct timespec *req, struct timespec *rem) {
+    RealtimeGuard::check(RealtimeGuard::BLOCKING_CALL, "nanosleep");
+    return __real_nanosleep(req, rem);
+}
+
+ssize_t __wrap_read(int fd, void *buf, size_t count) {
+    RealtimeGuard::check(RealtimeGuard::BLOCKING_CALL, "read");
+    return __real_read(fd, buf, count);
+}
+
+ssize_t __wrap_write(int fd, const void *buf, size_t count) {
+    RealtimeGuard::check(RealtimeGuard::BLOCKING_CALL, "write");
+    return __real_write(fd, buf, count);
+}
+
+int __wrap_poll(struct pollfd *fds, nfds_t nfds, int timeout) {
+    RealtimeGuard::check(RealtimeGuard::BLOCKING_CALL, "poll");
+    return __real_poll(fds, nfds, timeout);
+}
+
+#ifdef __ANDROID__
+
+// libc++ (namespace std::__ndk1) keeps these out of line in libc++_shared.so, so the pthread
+// calls they make never reach the wrappers above. The object is only passed through.
+
+void __wrap__ZNSt6__ndk15mutex4lockEv(void *mutex) {
+    RealtimeGuard::check(RealtimeGuard::LOCK, "std::mutex::lock");
+    __real__ZNSt6__ndk15mutex4lockEv(mutex);
+}
+
+void __wrap__ZNSt6__ndk118condition_variable4waitERNS_11unique_lockINS_5mutexEEE(void *cond,
+                                                                                 void *lock) {
+    RealtimeGuard::check(RealtimeGuard::LOCK, "std::condition_variable::wait");
+    __real__ZNSt6__ndk118condition_variable4waitERNS_11unique_lockINS_5mutexEEE(cond, lock);
+}
+
+#endif
+
+}
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef TUNEBLOB_REALTIMEGUARD_H
+#define TUNEBLOB_REALTIMEGUARD_H
+
+#include <cstdint>
+
+/**
+ * Debug checks for code that must stay real-time safe (i.e. the audio callback)
+ * When built with RT_GUARD, allocations, mutex locks and blocking system calls made on a
+ * thread inside a RealtimeScope are counted as violations, or abort the process when built
+ * with RT_GUARD_ABORT. The calls are intercepted with linker wrappers (see CMakeLists.txt).
+ * Only call sites in the tuner library itself are seen: pthread, libc and operator new calls,
+ * plus std::mutex::lock and std::condition_variable::wait on Android, where libc++_shared
+ * keeps them out of line. Calls made from inside other libraries (Oboe, libc++ internals
+ * such as std::this_thread::sleep_for) aren't caught.
+ */
+class RealtimeGuard {
+public:
+
+    /**
+     * Kinds of calls that aren't allowed on a real-time thread
+     */
+    enum Violation {
+        ALLOCATION,
+        LOCK,
+        BLOCKING_CALL,
+        NUM_VIOLATIONS
+    };
+
+    static bool isEnabled();
+    static void enter();
+    static void leave();
+    static bool isRealtime();
+    static void check(Violation type, const char *call);
+    static int64_t getViolations(Violation type);
+    static int64_t getTotalViolations();
+    static void resetViolations();
+    static void report();
+};
+
+/**
+ * Marks the current thread as real-time until the end of the scope
+ * Compiles to nothing unless RT_GUARD is defined. The constructor and destructor stay
+ * user-provided either way, so a scope is never flagged as an unused variable.
+ */
+class RealtimeScope {
+public:
+#ifdef RT_GUARD
+    RealtimeScope() { RealtimeGuard::enter(); }
+    ~RealtimeScope() { RealtimeGuard::leave(); }
+#else
+    RealtimeScope() {}
+    ~RealtimeScope() {}
+#endif
+};
+
+
+#endif //TUNEBLOB_REALTIMEGUARD_H
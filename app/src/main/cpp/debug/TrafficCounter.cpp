@@ -0,0 +1,39 @@
+#include <atomic>
+#include "TrafficCounter.h"
+
+static std::atomic<int64_t> bytes{0};
+
+/**
+ * Check if counting was compiled in
+ * @return True if built with TRAFFIC_COUNTERS
+ */
+bool TrafficCounter::isEnabled() {
+#ifdef TRAFFIC_COUNTERS
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * Count bytes loaded or stored
+ * @param count Number of bytes
+ */
+void TrafficCounter::add(int64_t count) {
+    bytes.fetch_add(count, std::memory_order_relaxed);
+}
+
+/**
+ * Get the bytes counted since the last reset
+ * @return Number of bytes
+ */
+int64_t TrafficCounter::getBytes() {
+    return bytes.load(std::memory_order_relaxed);
+}
+
+/**
+ * Reset the count
+ */
+void TrafficCounter::reset() {
+    bytes = 0;
+}
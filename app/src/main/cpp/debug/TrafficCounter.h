@@ -0,0 +1,28 @@
+#ifndef TUNEBLOB_TRAFFICCOUNTER_H
+#define TUNEBLOB_TRAFFICCOUNTER_H
+
+#include <cstdint>
+
+/**
+ * Debug count of the bytes the analysis path reads and writes
+ * Each loop over a buffer adds what it loaded and stored once it's done, from its actual
+ * iteration counts, so benches can report measured traffic per stage. Counting is compiled
+ * in with TRAFFIC_COUNTERS (see CMakeLists.txt) and COUNT_TRAFFIC is a no-op otherwise.
+ */
+class TrafficCounter {
+public:
+
+    static bool isEnabled();
+    static void add(int64_t bytes);
+    static int64_t getBytes();
+    static void reset();
+};
+
+#ifdef TRAFFIC_COUNTERS
+#define COUNT_TRAFFIC(bytes) TrafficCounter::add((int64_t) (bytes))
+#else
+#define COUNT_TRAFFIC(bytes) ((void) 0)
+#endif
+
+
+#endif //TUNEBLOB_TRAFFICCOUNTER_H
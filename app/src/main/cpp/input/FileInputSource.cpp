@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include "FileInputSource.h"
+#include "../data/SampleKernels.h"
+
+/**
+ * Create a file source
+ * @param path File path
+ * @param blockFrames Number of samples delivered per block
+ * @param speed Multiple of real time to deliver input at (0 = as fast as possible)
+ * @param loop True to start over at the end of the file instead of finishing
+ * @param encoding WAV or a raw sample encoding
+ * @param rawSampleRate Sample rate of raw files
+ * @param rawChannels Number of interleaved channels in raw files
+ */
+FileInputSource::FileInputSource(const std::string &path, int blockFrames, float speed, bool loop,
+                                 Encoding encoding, int rawSampleRate, int rawChannels)
+: ThreadedInputSource(rawSampleRate, blockFrames, speed), path(path), loop(loop),
+encoding(encoding), channels(rawChannels) {
+}
+
+FileInputSource::~FileInputSource() {
+    stop();
+}
+
+/**
+ * Load and decode the file
+ * @param listener Listener that receives the input
+ * @param preferred Ignored (blocks are always floats)
+ * @return 0 on success, FILE_NOT_FOUND or FILE_UNSUPPORTED
+ */
+int FileInputSource::open(Listener *listener, SampleBuffer::Format preferred) {
+    FILE *file = fopen(path.c_str(), "rb");
+    if (file == nullptr)
+        return FILE_NOT_FOUND;
+    std::vector<uint8_t> data;
+    uint8_t chunk[65536];
+    size_t read;
+    while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0)
+        data.insert(data.end(), chunk, chunk + read);
+    fclose(file);
+
+    bool decoded;
+    if (encoding == WAV) {
+        decoded = parseWav(data);
+    } else {
+        decode(data.data(), data.size(), encoding == RAW_INT16 ? 16 : 32, encoding == RAW_FLOAT);
+        decoded = true;
+    }
+    if (!decoded || samples.empty())
+        return FILE_UNSUPPORTED;
+
+    position = 0;
+    return ThreadedInputSource::open(listener, preferred);
+}
+
+/**
+ * Get the length of the file (known once opened)
+ * @return Number of mono samples
+ */
+int FileInputSource::getNumFrames() const {
+    return (int) samples.size();
+}
+
+/**
+ * Copy the next block from the decoded file
+ * @param out Output samples
+ * @param maxFrames Maximum number of samples
+ * @return Number of samples read
+ */
+int FileInputSource::read(float *out, int maxFrames) {
+    if (position >= samples.size()) {
+        if (!loop)
+            return 0;
+        position = 0;
+    }
+    int frames = (int) std::min((size_t) maxFrames, samples.size() - position);
+    memcpy(out, samples.data() + position, frames * sizeof(float));
+    position += frames;
+    return frames;
+}
+
+/**
+ * Read the format and sample data from a RIFF/WAVE file
+ * @param data File contents
+ * @return True if the file is a supported WAV file
+ */
+bool FileInputSource::parseWav(const std::vector<uint8_t> &data) {
+    if (data.size() < 12 || memcmp(data.data(), "RIFF", 4) != 0 || memcmp(data.data() + 8, "WAVE", 4) != 0)
+        return false;
+
+    int format = 0, bits = 0;
+    size_t pos = 12;
+    while (pos + 8 <= data.size()) {
+        const uint8_t *chunk = data.data() + pos;
+        uint32_t size = chunk[4] | (chunk[5] << 8) | (chunk[6] << 16) | ((uint32_t) chunk[7] << 24);
+        size_t body = pos + 8;
+        size = (uint32_t) std::min((size_t) size, data.size() - body);
+
+        if (memcmp(chunk, "fmt ", 4) == 0 && size >= 16) {
+            const uint8_t *fmt = data.data() + body;
+            format = fmt[0] | (fmt[1] << 8);
+            channels = fmt[2] | (fmt[3] << 8);
+            sampleRate = fmt[4] | (fmt[5] << 8) | (fmt[6] << 16) | (fmt[7] << 24);
+            bits = fmt[14] | (fmt[15] << 8);
+
+            // WAVE_FORMAT_EXTENSIBLE keeps the real format in the sub-format GUID
+            if (format == 0xFFFE && size >= 26)
+                format = fmt[24] | (fmt[25] << 8);
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            bool pcm16 = format == 1 && bits == 16;
+            bool float32 = format == 3 && bits == 32;
+            if (channels < 1 || sampleRate <= 0 || (!pcm16 && !float32))
+                return false;
+            decode(data.data() + body, size, bits, float32);
+            return true;
+        }
+
+        // Chunks are padded to an even size
+        pos = body + size + (size & 1);
+    }
+    return false;
+}
+
+/**
+ * Decode interleaved samples to mono floats (channels are averaged)
+ * @param data Sample data
+ * @param size Size of the data in bytes
+ * @param bits Bits per sample (16 or 32)
+ * @param isFloat True for 32-bit floats, false for 16-bit integers
+ */
+void FileInputSource::decode(const uint8_t *data, size_t size, int bits, bool isFloat) {
+    channels = std::max(1, channels);
+    size_t frames = size / (bits / 8) / channels;
+    samples.assign(frames, 0);
+    float scale = 1.0f / channels;
+    for (size_t i = 0; i < frames; i++) {
+        float sum = 0;
+        for (int c = 0; c < channels; c++) {
+            size_t index = i * channels + c;
+            if (isFloat) {
+                float value;
+                memcpy(&value, data + index * 4, 4);
+                sum += value;
+            } else {
+                int16_t value;
+                memcpy(&value, data + index * 2, 2);
+                sum += value / INT16_SCALE;
+            }
+        }
+        samples[i] = sum * scale;
+    }
+}
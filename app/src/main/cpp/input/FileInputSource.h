@@ -0,0 +1,57 @@
+#ifndef TUNEBLOB_FILEINPUTSOURCE_H
+#define TUNEBLOB_FILEINPUTSOURCE_H
+
+#include <string>
+#include <vector>
+#include "ThreadedInputSource.h"
+
+/**
+ * Input read from a WAV file (16-bit PCM or 32-bit float) or a raw sample file
+ * The whole file is decoded to mono floats when the source is opened, after which
+ * getSampleRate() returns the rate from the WAV header
+ */
+class FileInputSource : public ThreadedInputSource {
+public:
+
+    /**
+     * Sample encodings for raw files
+     */
+    enum Encoding {
+        WAV,        // Format is read from the file header
+        RAW_FLOAT,  // Raw 32-bit floats
+        RAW_INT16   // Raw 16-bit integers
+    };
+
+    FileInputSource(const std::string &path, int blockFrames = 256, float speed = 1,
+                    bool loop = false, Encoding encoding = WAV, int rawSampleRate = 48000,
+                    int rawChannels = 1);
+    ~FileInputSource() override;
+
+    int open(Listener *listener, SampleBuffer::Format preferred) override;
+    int getNumFrames() const;
+
+protected:
+
+    int read(float *out, int maxFrames) override;
+
+private:
+
+    bool parseWav(const std::vector<uint8_t> &data);
+    void decode(const uint8_t *data, size_t size, int bits, bool isFloat);
+
+    const std::string path;
+    const bool loop;
+    const Encoding encoding;
+    int channels;
+    std::vector<float> samples;
+    size_t position = 0;
+};
+
+/**
+ * Error codes returned by FileInputSource::open
+ */
+static const int FILE_NOT_FOUND = -2;
+static const int FILE_UNSUPPORTED = -3;
+
+
+#endif //TUNEBLOB_FILEINPUTSOURCE_H
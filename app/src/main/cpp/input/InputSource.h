@@ -0,0 +1,60 @@
+#ifndef TUNEBLOB_INPUTSOURCE_H
+#define TUNEBLOB_INPUTSOURCE_H
+
+#include <cstdint>
+#include "../tuner/SampleBuffer.h"
+
+/**
+ * Source of mono input blocks for the tuner engine (audio device, file, generator...)
+ */
+class InputSource {
+public:
+
+    /**
+     * Receives blocks of input from a source
+     * For device sources this is called on the real-time audio thread
+     */
+    class Listener {
+    public:
+
+        virtual ~Listener() = default;
+
+        /**
+         * Handle a block of input
+         * @param samples Sample data
+         * @param numFrames Number of samples
+         * @return False to stop the source
+         */
+        virtual bool onInput(const float *samples, int numFrames) = 0;
+        virtual bool onInput(const int16_t *samples, int numFrames) = 0;
+    };
+
+    virtual ~InputSource() = default;
+
+    /**
+     * Prepare the source, after which its sample rate and format are known
+     * @param listener Listener that receives the input once started
+     * @param preferred Preferred sample format (sources may deliver another one)
+     * @return 0 on success, or a source-specific error code
+     */
+    virtual int open(Listener *listener, SampleBuffer::Format preferred) = 0;
+
+    /**
+     * Start delivering input
+     * @return 0 on success, or a source-specific error code
+     */
+    virtual int start() = 0;
+
+    /**
+     * Stop delivering input and release the source
+     * Once this returns the listener is never called again
+     * @return 0 on success, or a source-specific error code
+     */
+    virtual int stop() = 0;
+
+    virtual int getSampleRate() const = 0;
+    virtual SampleBuffer::Format getFormat() const = 0;
+};
+
+
+#endif //TUNEBLOB_INPUTSOURCE_H
@@ -0,0 +1,97 @@
+#include "OboeInputSource.h"
+#include "../debug/RealtimeGuard.h"
+
+/**
+ * Create an audio device source
+ * @param deviceId Audio input device ID
+ * @param channels Number of channels used by the input
+ * @param sampleRate Requested sample rate
+ */
+OboeInputSource::OboeInputSource(int deviceId, int channels, int sampleRate)
+: deviceId(deviceId), channels(channels), sampleRate(sampleRate) {
+}
+
+OboeInputSource::~OboeInputSource() {
+    stop();
+}
+
+/**
+ * Open the input stream
+ * @param listener Listener that receives the input
+ * @param preferred Preferred sample format (16-bit input is cheaper on low-end devices)
+ * @return Oboe result code
+ */
+int OboeInputSource::open(Listener *listener, SampleBuffer::Format preferred) {
+    this->listener = listener;
+
+    oboe::AudioStreamBuilder builder;
+    oboe::Result result = builder.setDeviceId(deviceId)
+            ->setChannelCount(channels)
+            ->setSampleRate(sampleRate)
+            ->setSharingMode(oboe::SharingMode::Exclusive)
+            ->setDirection(oboe::Direction::Input)
+            ->setPerformanceMode(oboe::PerformanceMode::LowLatency)
+            ->setSampleRateConversionQuality(oboe::SampleRateConversionQuality::Medium)
+            ->setFormat(preferred == SampleBuffer::INT16 ? oboe::AudioFormat::I16 : oboe::AudioFormat::Float)
+            ->setDataCallback(this)
+            ->openStream(mStream);
+    return static_cast<int>(result);
+}
+
+/**
+ * Start the input stream
+ * @return Oboe result code
+ */
+int OboeInputSource::start() {
+    return static_cast<int>(mStream->requestStart());
+}
+
+/**
+ * Stop and close the input stream
+ * @return Oboe result code
+ */
+int OboeInputSource::stop() {
+    if (!mStream)
+        return static_cast<int>(oboe::Result::OK);
+    oboe::Result result = mStream->stop();
+    mStream->close();
+    mStream.reset();
+    return static_cast<int>(result);
+}
+
+/**
+ * Get the sample rate the stream was opened with
+ * @return Sample rate in hertz
+ */
+int OboeInputSource::getSampleRate() const {
+    return mStream ? mStream->getSampleRate() : sampleRate;
+}
+
+/**
+ * Get the format the stream delivers, which may differ from the preferred one
+ * @return Sample format
+ */
+SampleBuffer::Format OboeInputSource::getFormat() const {
+    return mStream && mStream->getFormat() == oboe::AudioFormat::I16 ?
+            SampleBuffer::INT16 : SampleBuffer::FLOAT;
+}
+
+/**
+ * Called whenever a new batch is samples have been received from the input device
+ * @param oboeStream Audio stream instance
+ * @param inputData Audio sample data
+ * @param numFrames Number of samples
+ * @return Whether to continue listening or stop
+ */
+oboe::DataCallbackResult
+OboeInputSource::onAudioReady(oboe::AudioStream *oboeStream, void *inputData, int32_t numFrames) {
+    RealtimeScope realtime;
+
+    bool keepGoing;
+    if (oboeStream->getFormat() == oboe::AudioFormat::I16)
+        keepGoing = listener->onInput(static_cast<const int16_t *>(inputData), numFrames);
+    else
+        keepGoing = listener->onInput(static_cast<const float *>(inputData), numFrames);
+
+    return keepGoing ? oboe::DataCallbackResult::Continue : oboe::DataCallbackResult::Stop;
+}
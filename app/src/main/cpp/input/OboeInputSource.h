@@ -0,0 +1,35 @@
+#ifndef TUNEBLOB_OBOEINPUTSOURCE_H
+#define TUNEBLOB_OBOEINPUTSOURCE_H
+
+#include <memory>
+#include <oboe/Oboe.h>
+#include "InputSource.h"
+
+/**
+ * Input from an audio device through an Oboe input stream
+ */
+class OboeInputSource : public InputSource, public oboe::AudioStreamDataCallback {
+public:
+
+    OboeInputSource(int deviceId, int channels, int sampleRate);
+    ~OboeInputSource() override;
+
+    int open(Listener *listener, SampleBuffer::Format preferred) override;
+    int start() override;
+    int stop() override;
+    int getSampleRate() const override;
+    SampleBuffer::Format getFormat() const override;
+
+    oboe::DataCallbackResult onAudioReady(oboe::AudioStream *oboeStream, void *audioData, int32_t numFrames) override;
+
+private:
+
+    const int deviceId;
+    const int channels;
+    const int sampleRate;
+    Listener *listener = nullptr;
+    std::shared_ptr<oboe::AudioStream> mStream;
+};
+
+
+#endif //TUNEBLOB_OBOEINPUTSOURCE_H
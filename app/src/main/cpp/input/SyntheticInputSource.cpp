@@ -0,0 +1,62 @@
+#include <algorithm>
+#include <cmath>
+#include "SyntheticInputSource.h"
+#include "../PI.h"
+
+/**
+ * Create a generator
+ * @param sampleRate Sample rate in hertz
+ * @param frequency Fundamental frequency in hertz
+ * @param amplitude Peak amplitude of the tone
+ * @param harmonics Number of partials (harmonic n has amplitude 1/n)
+ * @param noise Amplitude of white noise added to the tone
+ * @param blockFrames Number of samples delivered per block
+ * @param speed Multiple of real time to deliver input at (0 = as fast as possible)
+ */
+SyntheticInputSource::SyntheticInputSource(int sampleRate, double frequency, float amplitude,
+                                           int harmonics, float noise, int blockFrames, float speed)
+: ThreadedInputSource(sampleRate, blockFrames, speed), frequency(frequency), amplitude(amplitude),
+harmonics(std::max(1, harmonics)), noise(noise) {
+}
+
+SyntheticInputSource::~SyntheticInputSource() {
+    stop();
+}
+
+/**
+ * Change the fundamental frequency (takes effect at the next block)
+ * @param frequency Frequency in hertz
+ */
+void SyntheticInputSource::setFrequency(double frequency) {
+    this->frequency = frequency;
+}
+
+/**
+ * Generate the next block
+ * @param out Output samples
+ * @param maxFrames Number of samples to generate
+ * @return Number of samples generated
+ */
+int SyntheticInputSource::read(float *out, int maxFrames) {
+    double step = 2 * PI * frequency / sampleRate;
+    float norm = 0;
+    for (int h = 1; h <= harmonics; h++)
+        norm += 1.0f / h;
+
+    for (int i = 0; i < maxFrames; i++) {
+        float value = 0;
+        for (int h = 1; h <= harmonics; h++)
+            value += (float) sin(phase * h) / h;
+        value *= amplitude / norm;
+
+        // Small linear congruential generator so the noise is the same on every run
+        if (noise > 0) {
+            seed = seed * 1664525u + 1013904223u;
+            value += noise * ((float) (seed >> 8) / (1 << 24) * 2 - 1);
+        }
+
+        out[i] = value;
+        phase = fmod(phase + step, 2 * PI);
+    }
+    return maxFrames;
+}
@@ -0,0 +1,35 @@
+#ifndef TUNEBLOB_SYNTHETICINPUTSOURCE_H
+#define TUNEBLOB_SYNTHETICINPUTSOURCE_H
+
+#include <cstdint>
+#include "ThreadedInputSource.h"
+
+/**
+ * Generated test input: a tone with a number of harmonics plus optional noise
+ */
+class SyntheticInputSource : public ThreadedInputSource {
+public:
+
+    SyntheticInputSource(int sampleRate, double frequency, float amplitude = 0.5f,
+                         int harmonics = 1, float noise = 0, int blockFrames = 256,
+                         float speed = 1);
+    ~SyntheticInputSource() override;
+
+    void setFrequency(double frequency);
+
+protected:
+
+    int read(float *out, int maxFrames) override;
+
+private:
+
+    std::atomic<double> frequency;
+    const float amplitude;
+    const int harmonics;
+    const float noise;
+    double phase = 0;
+    uint32_t seed = 1;
+};
+
+
+#endif //TUNEBLOB_SYNTHETICINPUTSOURCE_H
@@ -0,0 +1,131 @@
+#include <chrono>
+#include "ThreadedInputSource.h"
+#include "../data/SampleKernels.h"
+#include "../debug/RealtimeGuard.h"
+
+/**
+ * Create a threaded source
+ * @param sampleRate Sample rate in hertz
+ * @param blockFrames Number of samples delivered per block (like a device burst)
+ * @param speed Multiple of real time to deliver input at (0 = as fast as possible)
+ */
+ThreadedInputSource::ThreadedInputSource(int sampleRate, int blockFrames, float speed)
+: sampleRate(sampleRate), blockFrames(blockFrames), speed(speed) {
+}
+
+/**
+ * Subclasses must call stop() in their own destructor, since the thread calls read()
+ */
+ThreadedInputSource::~ThreadedInputSource() {
+    stop();
+}
+
+/**
+ * Prepare the source
+ * @param listener Listener that receives the input
+ * @param preferred Sample format to deliver (16-bit blocks are converted from the floats the
+ *                  subclass reads, like a device that only offers 16-bit input)
+ * @return 0
+ */
+int ThreadedInputSource::open(Listener *listener, SampleBuffer::Format preferred) {
+    this->listener = listener;
+    format = preferred;
+    block.resize(blockFrames);
+    block16.resize(format == SampleBuffer::INT16 ? blockFrames : 0);
+    return 0;
+}
+
+/**
+ * Start the delivery thread
+ * @return 0 on success, -1 if the source wasn't opened or is already running
+ */
+int ThreadedInputSource::start() {
+    if (listener == nullptr || running)
+        return -1;
+    running = true;
+    finished = false;
+    thread = std::thread(&ThreadedInputSource::run, this);
+    return 0;
+}
+
+/**
+ * Stop and join the delivery thread
+ * @return 0
+ */
+int ThreadedInputSource::stop() {
+    running = false;
+    if (thread.joinable())
+        thread.join();
+    return 0;
+}
+
+/**
+ * Get the sample rate
+ * @return Sample rate in hertz
+ */
+int ThreadedInputSource::getSampleRate() const {
+    return sampleRate;
+}
+
+/**
+ * Get the format blocks are delivered in, which is the one preferred when opened
+ * @return Sample format
+ */
+SampleBuffer::Format ThreadedInputSource::getFormat() const {
+    return format;
+}
+
+/**
+ * Get the number of samples delivered to the listener so far
+ * @return Number of samples
+ */
+int64_t ThreadedInputSource::getFramesDelivered() const {
+    return framesDelivered;
+}
+
+/**
+ * Check if the input has ended (or the listener asked to stop)
+ * @return True if finished
+ */
+bool ThreadedInputSource::isFinished() const {
+    return finished;
+}
+
+/**
+ * Delivery thread loop, paced against a steady clock so that timing errors don't accumulate
+ */
+void ThreadedInputSource::run() {
+    auto begin = std::chrono::steady_clock::now();
+    int64_t delivered = 0;
+
+    while (running) {
+        int frames = read(block.data(), blockFrames);
+        if (frames <= 0)
+            break;
+
+        // Convert before the real-time scope, since a device would deliver 16-bit samples
+        if (format == SampleBuffer::INT16)
+            SampleKernels::toInt16(block.data(), block16.data(), frames);
+
+        bool keepGoing;
+        {
+            RealtimeScope realtime;
+            if (format == SampleBuffer::INT16)
+                keepGoing = listener->onInput(block16.data(), frames);
+            else
+                keepGoing = listener->onInput(block.data(), frames);
+        }
+        delivered += frames;
+        framesDelivered = delivered;
+        if (!keepGoing)
+            break;
+
+        // Wait until this block would have finished arriving from a device
+        if (speed > 0) {
+            auto due = begin + std::chrono::nanoseconds(
+                    (int64_t) (delivered * 1e9 / (sampleRate * (double) speed)));
+            std::this_thread::sleep_until(due);
+        }
+    }
+    finished = true;
+}
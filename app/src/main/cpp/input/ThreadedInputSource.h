@@ -0,0 +1,59 @@
+#ifndef TUNEBLOB_THREADEDINPUTSOURCE_H
+#define TUNEBLOB_THREADEDINPUTSOURCE_H
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "InputSource.h"
+
+/**
+ * Base for sources that aren't driven by a device (files, generators)
+ * A thread reads float blocks from the subclass and delivers them in the listener's
+ * preferred format in real time, at a multiple of real time, or as fast as the listener
+ * takes them. The listener call is marked real-time so the engine is held to the same rules
+ * as with a device.
+ */
+class ThreadedInputSource : public InputSource {
+public:
+
+    ThreadedInputSource(int sampleRate, int blockFrames, float speed);
+    ~ThreadedInputSource() override;
+
+    int open(Listener *listener, SampleBuffer::Format preferred) override;
+    int start() override;
+    int stop() override;
+    int getSampleRate() const override;
+    SampleBuffer::Format getFormat() const override;
+    int64_t getFramesDelivered() const;
+    bool isFinished() const;
+
+protected:
+
+    /**
+     * Read the next block of input
+     * @param out Output samples
+     * @param maxFrames Maximum number of samples
+     * @return Number of samples read (0 once the input has ended)
+     */
+    virtual int read(float *out, int maxFrames) = 0;
+
+    int sampleRate;
+
+private:
+
+    void run();
+
+    const int blockFrames;
+    const float speed;
+    Listener *listener = nullptr;
+    SampleBuffer::Format format = SampleBuffer::FLOAT;
+    std::vector<float> block;
+    std::vector<int16_t> block16;
+    std::thread thread;
+    std::atomic<bool> running{false};
+    std::atomic<bool> finished{false};
+    std::atomic<int64_t> framesDelivered{0};
+};
+
+
+#endif //TUNEBLOB_THREADEDINPUTSOURCE_H
@@ -1,9 +1,29 @@
 #include <jni.h>
+#include <algorithm>
 #include <string>
 #include <iostream>
+#include <vector>
 #include "tuner/TunerInputEngine.h"
+#include "input/OboeInputSource.h"
 #include "logging_macros.h"
 
+/**
+ * Get a native buffer for engine output, which is copied into the Java array afterwards
+ * Engine calls take locks (and getWaveform can filter the whole buffer), so they're never
+ * made inside a GetPrimitiveArrayCritical region, where waiting would hold up the GC.
+ * Each calling thread keeps its own buffers, which only grow with the views.
+ * @param index Which of the thread's buffers to use
+ * @param size Number of floats needed
+ * @return Buffer of at least size floats
+ */
+static float *scratchBuffer(int index, int size) {
+    static thread_local std::vector<float> buffers[2];
+    std::vector<float> &buffer = buffers[index];
+    if (buffer.size() < (size_t) size)
+        buffer.resize(size);
+    return buffer.data();
+}
+
 extern "C" {
 
 JNIEXPORT jlong JNICALL
@@ -27,10 +47,22 @@ Java_software_blob_audio_tuner_engine_TunerInputEngine_setParameters(
         jlong engineHandle,
         jfloat buffer_size,
         jfloat min_amplitude,
-        jfloat max_frequency) {
+        jfloat max_frequency,
+        jboolean int16_input) {
+
+    auto *engine = reinterpret_cast<TunerInputEngine *>(engineHandle);
+    return engine->setParameters(buffer_size, min_amplitude, max_frequency, int16_input);
+}
+
+JNIEXPORT jboolean JNICALL
+Java_software_blob_audio_tuner_engine_TunerInputEngine_setTracking(
+        JNIEnv *env,
+        jclass clazz,
+        jlong engineHandle,
+        jboolean tracking) {
 
     auto *engine = reinterpret_cast<TunerInputEngine *>(engineHandle);
-    return engine->setParameters(buffer_size, min_amplitude, max_frequency);
+    return engine->setTracking(tracking);
 }
 
 JNIEXPORT jint JNICALL
@@ -43,7 +75,7 @@ Java_software_blob_audio_tuner_engine_TunerInputEngine_startEngine(
         jint sampleRate) {
 
     auto *engine = reinterpret_cast<TunerInputEngine *>(engineHandle);
-    return static_cast<jint>(engine->start(deviceId, channels, sampleRate));
+    return static_cast<jint>(engine->start(std::make_shared<OboeInputSource>(deviceId, channels, sampleRate)));
 }
 
 JNIEXPORT jint JNICALL
@@ -77,17 +109,157 @@ Java_software_blob_audio_tuner_engine_TunerInputEngine_queryFrequency(
     return static_cast<jfloat>(engine->queryFrequency());
 }
 
+JNIEXPORT jint JNICALL
+Java_software_blob_audio_tuner_engine_TunerInputEngine_fetchHistory(
+        JNIEnv *env,
+        jclass clazz,
+        jlong engineHandle,
+        jlongArray sequence,
+        jdoubleArray times,
+        jfloatArray values) {
+
+    auto *engine = reinterpret_cast<TunerInputEngine *>(engineHandle);
+    int maxEntries = std::min(env->GetArrayLength(times), env->GetArrayLength(values) / 2);
+    jlong since;
+    env->GetLongArrayRegion(sequence, 0, 1, &since);
+
+    // Timestamps stay in double precision so they keep up with the tracking hop in long sessions
+    static thread_local std::vector<PitchHistory::Entry> results;
+    static thread_local std::vector<double> resultTimes;
+    if (results.size() < (size_t) maxEntries) {
+        results.resize(maxEntries);
+        resultTimes.resize(maxEntries);
+    }
+    int64_t next = since;
+    int count = engine->fetchHistory(next, results.data(), maxEntries);
+    float *resultValues = scratchBuffer(0, count * 2);
+    for (int i = 0; i < count; i++) {
+        resultTimes[i] = results[i].time;
+        resultValues[i * 2] = results[i].frequency;
+        resultValues[i * 2 + 1] = results[i].confidence;
+    }
+    env->SetDoubleArrayRegion(times, 0, count, resultTimes.data());
+    env->SetFloatArrayRegion(values, 0, count * 2, resultValues);
+
+    since = next;
+    env->SetLongArrayRegion(sequence, 0, 1, &since);
+    return count;
+}
+
 JNIEXPORT void JNICALL
+Java_software_blob_audio_tuner_engine_TunerInputEngine_setStrobeReference(
+        JNIEnv *env,
+        jclass clazz,
+        jlong engineHandle,
+        jfloat frequency) {
+
+    auto *engine = reinterpret_cast<TunerInputEngine *>(engineHandle);
+    engine->setStrobeReference(frequency);
+}
+
+JNIEXPORT jint JNICALL
+Java_software_blob_audio_tuner_engine_TunerInputEngine_fetchStrobe(
+        JNIEnv *env,
+        jclass clazz,
+        jlong engineHandle,
+        jlongArray sequence,
+        jfloatArray out) {
+
+    auto *engine = reinterpret_cast<TunerInputEngine *>(engineHandle);
+    int maxFrames = env->GetArrayLength(out) / STROBE_FRAME_VALUES;
+    jlong since;
+    env->GetLongArrayRegion(sequence, 0, 1, &since);
+
+    int64_t next = since;
+    float *frames = scratchBuffer(0, maxFrames * STROBE_FRAME_VALUES);
+    int count = engine->fetchStrobe(next, frames, maxFrames);
+    env->SetFloatArrayRegion(out, 0, count * STROBE_FRAME_VALUES, frames);
+
+    since = next;
+    env->SetLongArrayRegion(sequence, 0, 1, &since);
+    return count;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_software_blob_audio_tuner_engine_TunerInputEngine_isInputActive(
+        JNIEnv *env,
+        jclass clazz,
+        jlong engineHandle) {
+
+    auto *engine = reinterpret_cast<TunerInputEngine *>(engineHandle);
+    return static_cast<jboolean>(engine->isInputActive());
+}
+
+JNIEXPORT jlong JNICALL
+Java_software_blob_audio_tuner_engine_TunerInputEngine_getAnalyzedHops(
+        JNIEnv *env,
+        jclass clazz,
+        jlong engineHandle) {
+
+    auto *engine = reinterpret_cast<TunerInputEngine *>(engineHandle);
+    return static_cast<jlong>(engine->getAnalyzedHops());
+}
+
+JNIEXPORT jlong JNICALL
+Java_software_blob_audio_tuner_engine_TunerInputEngine_getSkippedHops(
+        JNIEnv *env,
+        jclass clazz,
+        jlong engineHandle) {
+
+    auto *engine = reinterpret_cast<TunerInputEngine *>(engineHandle);
+    return static_cast<jlong>(engine->getSkippedHops());
+}
+
+JNIEXPORT jint JNICALL
 Java_software_blob_audio_tuner_engine_TunerInputEngine_getSampleBuffer(
         JNIEnv *env,
         jclass clazz,
         jlong engineHandle,
+        jlongArray sequence,
         jfloatArray buf) {
 
     auto *engine = reinterpret_cast<TunerInputEngine *>(engineHandle);
-    auto *wav = engine->getWav();
+    int maxFrames = env->GetArrayLength(buf);
+    jlong since;
+    env->GetLongArrayRegion(sequence, 0, 1, &since);
+
+    int64_t next = since;
+    float *samples = scratchBuffer(0, maxFrames);
+    int count = engine->getWaveform(next, samples, maxFrames);
+    if (count > 0)
+        env->SetFloatArrayRegion(buf, 0, count, samples);
+
+    since = next;
+    env->SetLongArrayRegion(sequence, 0, 1, &since);
+    return count;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_software_blob_audio_tuner_engine_TunerInputEngine_getWaveformEnvelope(
+        JNIEnv *env,
+        jclass clazz,
+        jlong engineHandle,
+        jlongArray sequence,
+        jfloatArray min,
+        jfloatArray max) {
+
+    auto *engine = reinterpret_cast<TunerInputEngine *>(engineHandle);
+    int width = std::min(env->GetArrayLength(min), env->GetArrayLength(max));
+    jlong since;
+    env->GetLongArrayRegion(sequence, 0, 1, &since);
+
+    int64_t next = since;
+    float *minValues = scratchBuffer(0, width);
+    float *maxValues = scratchBuffer(1, width);
+    bool filled = engine->getEnvelope(next, minValues, maxValues, width);
+    if (filled) {
+        env->SetFloatArrayRegion(min, 0, width, minValues);
+        env->SetFloatArrayRegion(max, 0, width, maxValues);
+    }
 
-    env->SetFloatArrayRegion(buf, 0, wav->numFrames, wav->samples);
+    since = next;
+    env->SetLongArrayRegion(sequence, 0, 1, &since);
+    return static_cast<jboolean>(filled);
 }
 
 }
\ No newline at end of file
@@ -16,13 +16,14 @@
  */
 #ifndef __SAMPLE_ANDROID_DEBUG_H__
 #define __SAMPLE_ANDROID_DEBUG_H__
-#include <android/log.h>
-
 #if 1
 #ifndef MODULE_NAME
 #define MODULE_NAME  "TuneBlob"
 #endif
 
+#if defined(__ANDROID__)
+#include <android/log.h>
+
 #define LOGV(...) __android_log_print(ANDROID_LOG_VERBOSE, MODULE_NAME, __VA_ARGS__)
 #define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, MODULE_NAME, __VA_ARGS__)
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, MODULE_NAME, __VA_ARGS__)
@@ -32,6 +33,21 @@
 
 #define ASSERT(cond, ...) if (!(cond)) {__android_log_assert(#cond, MODULE_NAME, __VA_ARGS__);}
 #else
+// Host builds (benchmarks) log to stderr
+#include <cstdio>
+#include <cstdlib>
+
+#define HOST_LOG(level, ...) (fprintf(stderr, "%s %s: ", level, MODULE_NAME), fprintf(stderr, __VA_ARGS__), fputc('\n', stderr))
+#define LOGV(...)
+#define LOGD(...)
+#define LOGI(...) HOST_LOG("I", __VA_ARGS__)
+#define LOGW(...) HOST_LOG("W", __VA_ARGS__)
+#define LOGE(...) HOST_LOG("E", __VA_ARGS__)
+#define LOGF(...) HOST_LOG("F", __VA_ARGS__)
+
+#define ASSERT(cond, ...) if (!(cond)) {LOGF(__VA_ARGS__); abort();}
+#endif
+#else
 
 #define LOGV(...)
 #define LOGD(...)
@@ -0,0 +1,121 @@
+#include <algorithm>
+#include "AnalysisScheduler.h"
+#include "CoreBudget.h"
+
+/**
+ * Create a scheduler
+ * @param numThreads Number of analysis threads (at least 1)
+ */
+AnalysisScheduler::AnalysisScheduler(int numThreads) : stopping(false) {
+    sem_init(&ready, 0, 0);
+    numThreads = std::max(1, numThreads);
+    for (int i = 0; i < numThreads; i++)
+        threads.emplace_back(&AnalysisScheduler::run, this, i);
+}
+
+/**
+ * Stop and join all analysis threads
+ * Every job should have been removed by now
+ */
+AnalysisScheduler::~AnalysisScheduler() {
+    stopping = true;
+    for (size_t i = 0; i < threads.size(); i++)
+        sem_post(&ready);
+    for (auto &thread : threads)
+        thread.join();
+    sem_destroy(&ready);
+}
+
+/**
+ * Register a job so signals for it get served
+ * @param job Job to add
+ */
+void AnalysisScheduler::add(AnalysisJob *job) {
+    std::lock_guard<std::mutex> guard(lock);
+    job->home = nextHome;
+    nextHome = (nextHome + 1) % (int) threads.size();
+    jobs.push_back(job);
+}
+
+/**
+ * Unregister a job, waiting for it to finish if it's currently running
+ * Once this returns the job is never run again, so its owner can be destroyed
+ * @param job Job to remove
+ */
+void AnalysisScheduler::remove(AnalysisJob *job) {
+    std::unique_lock<std::mutex> guard(lock);
+    jobs.erase(std::remove(jobs.begin(), jobs.end(), job), jobs.end());
+    idle.wait(guard, [job] { return !job->busy; });
+    job->pending = false;
+}
+
+/**
+ * Queue a job to run because new input has arrived
+ * Lock-free and never blocks, so it can be called from the audio callback.
+ * Signals for a job that's already queued are merged.
+ * @param job Job to run
+ */
+void AnalysisScheduler::signal(AnalysisJob *job) {
+    if (!job->pending.exchange(true))
+        sem_post(&ready);
+}
+
+/**
+ * Get the number of analysis threads
+ * @return Number of threads
+ */
+int AnalysisScheduler::getNumThreads() const {
+    return (int) threads.size();
+}
+
+/**
+ * Get the process-wide scheduler, sized together with the shared worker pool so the two
+ * don't oversubscribe the big cores
+ * @return Shared scheduler
+ */
+std::shared_ptr<AnalysisScheduler> AnalysisScheduler::getShared() {
+    static std::shared_ptr<AnalysisScheduler> shared = std::make_shared<AnalysisScheduler>(
+            CoreBudget::getSchedulerThreads());
+    return shared;
+}
+
+/**
+ * Analysis thread loop
+ * @param worker Thread number
+ */
+void AnalysisScheduler::run(int worker) {
+    while (true) {
+        while (sem_wait(&ready) != 0);
+        if (stopping)
+            return;
+
+        // Keep going while there's pending work, which may have been signaled after this wake-up
+        AnalysisJob *job;
+        while ((job = claim(worker)) != nullptr) {
+            job->runAnalysis();
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                job->busy = false;
+            }
+            idle.notify_all();
+        }
+    }
+}
+
+/**
+ * Take a pending job, preferring those whose home is this thread before stealing others
+ * @param worker Thread number
+ * @return Job to run or null if there's nothing to do
+ */
+AnalysisJob *AnalysisScheduler::claim(int worker) {
+    std::lock_guard<std::mutex> guard(lock);
+    for (int steal = 0; steal < 2; steal++) {
+        for (AnalysisJob *job : jobs) {
+            if ((job->home == worker) == (steal == 0) && !job->busy && job->pending.exchange(false)) {
+                job->busy = true;
+                return job;
+            }
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,73 @@
+#ifndef TUNEBLOB_ANALYSISSCHEDULER_H
+#define TUNEBLOB_ANALYSISSCHEDULER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <semaphore.h>
+#include <thread>
+#include <vector>
+
+/**
+ * Analysis work that runs on the scheduler whenever its owner signals new input
+ */
+class AnalysisJob {
+public:
+
+    virtual ~AnalysisJob() = default;
+
+    /**
+     * Analyze the input that has arrived since the last run
+     * Never runs on more than one scheduler thread at a time
+     */
+    virtual void runAnalysis() = 0;
+
+private:
+    friend class AnalysisScheduler;
+
+    std::atomic<bool> pending{false};
+    bool busy = false;
+    int home = 0;
+};
+
+/**
+ * Process-wide pool of analysis threads shared by every input engine
+ * Each job has a home thread that serves it first, while idle threads steal pending jobs
+ * from the others. The number of threads is fixed, so CPU use follows the amount of audio
+ * being analyzed rather than the number of engines.
+ */
+class AnalysisScheduler {
+public:
+
+    explicit AnalysisScheduler(int numThreads);
+    ~AnalysisScheduler();
+
+    void add(AnalysisJob *job);
+    void remove(AnalysisJob *job);
+    void signal(AnalysisJob *job);
+    int getNumThreads() const;
+
+    static std::shared_ptr<AnalysisScheduler> getShared();
+
+private:
+
+    void run(int worker);
+    AnalysisJob *claim(int worker);
+
+    std::vector<std::thread> threads;
+    std::vector<AnalysisJob *> jobs;
+    std::mutex lock;
+    std::condition_variable idle;
+    sem_t ready;
+    std::atomic<bool> stopping;
+    int nextHome = 0;
+};
+
+/**
+ * Maximum number of threads in the shared scheduler
+ */
+static const int MAX_SCHEDULER_THREADS = 4;
+
+
+#endif //TUNEBLOB_ANALYSISSCHEDULER_H
@@ -0,0 +1,54 @@
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include "CoreBudget.h"
+#include "AnalysisScheduler.h"
+#include "WorkerPool.h"
+
+/**
+ * Count the cores that aren't in the slowest cluster (all of them on symmetric systems)
+ * @return Number of big cores
+ */
+int CoreBudget::countBigCores() {
+    int cores = std::max(1, (int) std::thread::hardware_concurrency());
+    std::vector<long> maxFreqs;
+    for (int i = 0; i < cores; i++) {
+        char path[96];
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cpufreq/cpuinfo_max_freq", i);
+        long freq = 0;
+        FILE *file = fopen(path, "r");
+        if (file != nullptr) {
+            if (fscanf(file, "%ld", &freq) != 1)
+                freq = 0;
+            fclose(file);
+        }
+        // Frequencies aren't readable, so assume every core is equal
+        if (freq <= 0)
+            return cores;
+        maxFreqs.push_back(freq);
+    }
+
+    long slowest = *std::min_element(maxFreqs.begin(), maxFreqs.end());
+    int big = (int) std::count_if(maxFreqs.begin(), maxFreqs.end(),
+                                  [slowest](long freq) { return freq > slowest; });
+    return big > 0 ? big : cores;
+}
+
+/**
+ * Get the number of threads for the shared scheduler: the big cores the pool doesn't take
+ * @return Number of scheduler threads (at least 1)
+ */
+int CoreBudget::getSchedulerThreads() {
+    int cores = countBigCores();
+    return std::max(1, std::min(MAX_SCHEDULER_THREADS, cores - getPoolWorkers()));
+}
+
+/**
+ * Get the number of helper threads for the shared worker pool: up to half the big cores,
+ * so a single busy engine still spreads its windows while many engines get whole cores
+ * @return Number of pool threads, not counting the calling scheduler thread
+ */
+int CoreBudget::getPoolWorkers() {
+    return std::min(MAX_SHARED_WORKERS, countBigCores() / 2);
+}
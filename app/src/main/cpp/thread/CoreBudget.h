@@ -0,0 +1,18 @@
+#ifndef TUNEBLOB_COREBUDGET_H
+#define TUNEBLOB_COREBUDGET_H
+
+/**
+ * Splits the big cores between the shared analysis scheduler and the shared worker pool
+ * Scheduler threads are the callers of the pool and only one of them fans out at a time,
+ * so with every scheduler thread busy no more threads run than there are big cores.
+ */
+class CoreBudget {
+public:
+
+    static int countBigCores();
+    static int getSchedulerThreads();
+    static int getPoolWorkers();
+};
+
+
+#endif //TUNEBLOB_COREBUDGET_H
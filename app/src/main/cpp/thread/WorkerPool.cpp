@@ -0,0 +1,116 @@
+#include <algorithm>
+#include "WorkerPool.h"
+#include "CoreBudget.h"
+
+/**
+ * Create a worker pool
+ * @param numThreads Number of threads to start (0 = everything runs on the caller)
+ */
+WorkerPool::WorkerPool(int numThreads) : next(0) {
+    for (int i = 0; i < numThreads; i++)
+        threads.emplace_back(&WorkerPool::run, this, i + 1);
+}
+
+/**
+ * Stop and join all worker threads
+ */
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto &thread : threads)
+        thread.join();
+}
+
+/**
+ * Run a task for each index and wait for all of them to finish
+ * If another thread is already using the pool the task runs entirely on the caller
+ * @param count Number of indices
+ * @param task Task to run, given the index and the worker number (0 to getNumWorkers() - 1)
+ */
+void WorkerPool::parallelFor(int count, const std::function<void(int, int)> &task) {
+    std::unique_lock<std::mutex> submit(submitLock, std::try_to_lock);
+    if (count <= 1 || threads.empty() || !submit.owns_lock()) {
+        for (int i = 0; i < count; i++)
+            task(i, 0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        this->task = &task;
+        this->count = count;
+        next.store(0);
+        remaining = count;
+        generation++;
+    }
+    wake.notify_all();
+
+    work(0);
+
+    // Wait for the remaining tasks and for every worker to leave this job
+    std::unique_lock<std::mutex> guard(lock);
+    finished.wait(guard, [this] { return remaining == 0 && active == 0; });
+    this->task = nullptr;
+}
+
+/**
+ * Get the number of workers that may run tasks, including the caller
+ * @return Number of workers
+ */
+int WorkerPool::getNumWorkers() const {
+    return (int) threads.size() + 1;
+}
+
+/**
+ * Get the process-wide pool, sized together with the shared scheduler whose threads call it
+ * @return Shared worker pool
+ */
+std::shared_ptr<WorkerPool> WorkerPool::getShared() {
+    static std::shared_ptr<WorkerPool> shared = std::make_shared<WorkerPool>(
+            CoreBudget::getPoolWorkers());
+    return shared;
+}
+
+/**
+ * Worker thread loop
+ * @param worker Worker number
+ */
+void WorkerPool::run(int worker) {
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> guard(lock);
+    while (true) {
+        wake.wait(guard, [this, seen] { return stopping || (task != nullptr && generation != seen); });
+        if (stopping)
+            return;
+        seen = generation;
+        active++;
+        guard.unlock();
+        work(worker);
+        guard.lock();
+        active--;
+        if (remaining == 0 && active == 0)
+            finished.notify_all();
+    }
+}
+
+/**
+ * Take indices from the current job until there are none left
+ * @param worker Worker number
+ */
+void WorkerPool::work(int worker) {
+    int done = 0;
+    int i;
+    while ((i = next.fetch_add(1)) < count) {
+        (*task)(i, worker);
+        done++;
+    }
+    if (done > 0) {
+        std::lock_guard<std::mutex> guard(lock);
+        remaining -= done;
+        if (remaining == 0 && active == 0)
+            finished.notify_all();
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef TUNEBLOB_WORKERPOOL_H
+#define TUNEBLOB_WORKERPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Small pool of persistent worker threads for splitting analysis work across cores
+ * The calling thread always takes part in the work as worker 0
+ */
+class WorkerPool {
+public:
+
+    explicit WorkerPool(int numThreads);
+    ~WorkerPool();
+
+    void parallelFor(int count, const std::function<void(int index, int worker)> &task);
+    int getNumWorkers() const;
+
+    static std::shared_ptr<WorkerPool> getShared();
+
+private:
+
+    void run(int worker);
+    void work(int worker);
+
+    std::vector<std::thread> threads;
+    std::mutex submitLock;
+    std::mutex lock;
+    std::condition_variable wake;
+    std::condition_variable finished;
+
+    // Current job (guarded by lock, except for the index counter)
+    const std::function<void(int, int)> *task = nullptr;
+    int count = 0;
+    std::atomic<int> next;
+    int remaining = 0;
+    int active = 0;
+    uint64_t generation = 0;
+    bool stopping = false;
+};
+
+/**
+ * Maximum number of threads in the shared pool (in addition to the caller)
+ */
+static const int MAX_SHARED_WORKERS = 3;
+
+
+#endif //TUNEBLOB_WORKERPOOL_H
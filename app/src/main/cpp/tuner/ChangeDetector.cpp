@@ -0,0 +1,75 @@
+#include <algorithm>
+#include "ChangeDetector.h"
+#include "../data/SampleKernels.h"
+
+/**
+ * Create a change detector
+ * @param windowFrames Number of frames per measured window
+ * @param floor RMS level below which changes are ignored (noise while silent)
+ */
+ChangeDetector::ChangeDetector(int windowFrames, float floor)
+: windowFrames(std::max(1, windowFrames)), floorSquared(floor * floor) {
+}
+
+/**
+ * Measure a block of float samples
+ * @param samples Sample data
+ * @param numFrames Number of samples
+ * @return True if a window completed in this block jumped or dropped in level
+ */
+bool ChangeDetector::process(const float *samples, int numFrames) {
+    bool changed = false;
+    while (numFrames > 0) {
+        int count = std::min(numFrames, windowFrames - windowFill);
+        changed |= update(SampleKernels::sumSquares(samples, count), count);
+        samples += count;
+        numFrames -= count;
+    }
+    return changed;
+}
+
+/**
+ * Measure a block of 16-bit samples
+ * @param samples Sample data
+ * @param numFrames Number of samples
+ * @return True if a window completed in this block jumped or dropped in level
+ */
+bool ChangeDetector::process(const int16_t *samples, int numFrames) {
+    bool changed = false;
+    while (numFrames > 0) {
+        int count = std::min(numFrames, windowFrames - windowFill);
+        changed |= update(SampleKernels::sumSquares(samples, count), count);
+        samples += count;
+        numFrames -= count;
+    }
+    return changed;
+}
+
+/**
+ * Add part of a window and compare the window with the envelope once it's complete
+ * @param sumSquares Sum of squares of the samples
+ * @param numFrames Number of samples (never past the end of the window)
+ * @return True if the window completed and changed level
+ */
+bool ChangeDetector::update(double sumSquares, int numFrames) {
+    windowSum += sumSquares;
+    windowFill += numFrames;
+    if (windowFill < windowFrames)
+        return false;
+
+    auto level = (float) (windowSum / windowFrames);
+    windowSum = 0;
+    windowFill = 0;
+
+    // Levels are mean squares, so the ratio is squared too
+    const float ratio = CHANGE_RATIO * CHANGE_RATIO;
+    bool changed = std::max(level, envelope) >= floorSquared &&
+            (level > envelope * ratio || level * ratio < envelope);
+
+    // Start over from a changed level instead of flagging it again while the envelope catches up
+    if (changed)
+        envelope = level;
+    else
+        envelope += (level - envelope) * CHANGE_SMOOTHING;
+    return changed;
+}
@@ -0,0 +1,42 @@
+#ifndef TUNEBLOB_CHANGEDETECTOR_H
+#define TUNEBLOB_CHANGEDETECTOR_H
+
+#include <cstdint>
+
+/**
+ * Cheap onset and level change detector for the audio thread
+ * Compares the mean square of each fixed window of input against a slow envelope of the
+ * previous windows. Windows are long enough to hold a full period of a low note, so the
+ * level doesn't wobble with where a block happens to cut the waveform.
+ */
+class ChangeDetector {
+public:
+
+    ChangeDetector(int windowFrames, float floor);
+
+    bool process(const float *samples, int numFrames);
+    bool process(const int16_t *samples, int numFrames);
+
+private:
+
+    bool update(double sumSquares, int numFrames);
+
+    const int windowFrames;
+    const float floorSquared;
+    double windowSum = 0;
+    int windowFill = 0;
+    float envelope = 0;
+};
+
+/**
+ * Level ratio (either way) between a window and the envelope that counts as a change (6 dB)
+ */
+static const float CHANGE_RATIO = 2.0f;
+
+/**
+ * Weight of each new window in the envelope
+ */
+static const float CHANGE_SMOOTHING = 0.25f;
+
+
+#endif //TUNEBLOB_CHANGEDETECTOR_H
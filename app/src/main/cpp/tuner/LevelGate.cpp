@@ -0,0 +1,87 @@
+#include <cmath>
+#include "LevelGate.h"
+#include "../data/SampleKernels.h"
+
+/**
+ * Create a level gate
+ * The gate starts closed and opens as soon as a block reaches the open threshold
+ * @param openThreshold Peak amplitude that opens the gate
+ * @param closeThreshold Peak amplitude the input must stay under for the gate to close
+ * @param holdFrames Number of quiet frames before the gate closes
+ */
+LevelGate::LevelGate(float openThreshold, float closeThreshold, int holdFrames)
+: openThreshold(openThreshold), closeThreshold(closeThreshold), holdFrames(holdFrames),
+quietFrames(0), open(false), peak(0), rms(0) {
+}
+
+/**
+ * Measure a block of float samples
+ * @param samples Sample data
+ * @param numFrames Number of samples
+ */
+void LevelGate::process(const float *samples, int numFrames) {
+    update(SampleKernels::peak(samples, numFrames),
+           SampleKernels::sumSquares(samples, numFrames), numFrames);
+}
+
+/**
+ * Measure a block of 16-bit samples
+ * @param samples Sample data
+ * @param numFrames Number of samples
+ */
+void LevelGate::process(const int16_t *samples, int numFrames) {
+    update((float) SampleKernels::peak(samples, numFrames) / INT16_SCALE,
+           SampleKernels::sumSquares(samples, numFrames), numFrames);
+}
+
+/**
+ * Check if the gate is open (input is loud enough to analyze)
+ * @return True if open
+ */
+bool LevelGate::isOpen() const {
+    return open.load(std::memory_order_acquire);
+}
+
+/**
+ * Get the peak amplitude of the latest block
+ * @return Peak amplitude (0 to 1)
+ */
+float LevelGate::getPeak() const {
+    return peak.load(std::memory_order_relaxed);
+}
+
+/**
+ * Get the RMS level of the latest block
+ * @return RMS level (0 to 1)
+ */
+float LevelGate::getRMS() const {
+    return rms.load(std::memory_order_relaxed);
+}
+
+/**
+ * Update the levels and gate state with a new block
+ * @param blockPeak Peak amplitude of the block
+ * @param sumSquares Sum of squares of the block
+ * @param numFrames Number of samples in the block
+ */
+void LevelGate::update(float blockPeak, double sumSquares, int numFrames) {
+    if (numFrames <= 0)
+        return;
+
+    peak.store(blockPeak, std::memory_order_relaxed);
+    rms.store((float) sqrt(sumSquares / numFrames), std::memory_order_relaxed);
+
+    if (blockPeak >= openThreshold) {
+        // Open immediately on loud input
+        quietFrames = 0;
+        open.store(true, std::memory_order_release);
+    } else if (blockPeak < closeThreshold) {
+        // Only close after the input has stayed quiet for the hold time
+        quietFrames += numFrames;
+        if (quietFrames >= holdFrames)
+            open.store(false, std::memory_order_release);
+    } else {
+        // Between the thresholds: keep the current state
+        quietFrames = 0;
+    }
+}
@@ -0,0 +1,42 @@
+#ifndef TUNEBLOB_LEVELGATE_H
+#define TUNEBLOB_LEVELGATE_H
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * Tracks input levels per audio block and gates analysis while the input is silent
+ * Updated on the audio thread and read from the analysis thread
+ */
+class LevelGate {
+public:
+
+    LevelGate(float openThreshold, float closeThreshold, int holdFrames);
+
+    void process(const float *samples, int numFrames);
+    void process(const int16_t *samples, int numFrames);
+    bool isOpen() const;
+    float getPeak() const;
+    float getRMS() const;
+
+private:
+
+    void update(float blockPeak, double sumSquares, int numFrames);
+
+    const float openThreshold;
+    const float closeThreshold;
+    const int holdFrames;
+    int quietFrames;
+
+    std::atomic<bool> open;
+    std::atomic<float> peak;
+    std::atomic<float> rms;
+};
+
+/**
+ * Close threshold relative to the open threshold (-6 dB)
+ */
+static const float GATE_HYSTERESIS = 0.5f;
+
+
+#endif //TUNEBLOB_LEVELGATE_H
@@ -0,0 +1,179 @@
+#include <algorithm>
+#include <cmath>
+#include "PhaseTracker.h"
+#include "../PI.h"
+
+/**
+ * Create a phase tracker
+ * @param sampleRate Sample rate of the analyzed buffer
+ * @param maxWindow Longest window (low pitches are measured over fewer periods)
+ */
+PhaseTracker::PhaseTracker(int sampleRate, int maxWindow)
+: sampleRate(sampleRate), maxWindow(maxWindow),
+  hopFrames(std::max(1, (int) lroundf(TRACK_HOP_SECONDS * sampleRate))) {
+    table = new float[maxWindow * TRACK_HARMONICS * 2];
+}
+
+PhaseTracker::~PhaseTracker() {
+    delete[] table;
+}
+
+/**
+ * Anchor the tracker to a coarse pitch from the full detector
+ * @param frequency Coarse pitch in hertz, or 0 to stop tracking
+ * @param confidence Confidence of the coarse pitch, reported with each tracked pitch
+ */
+void PhaseTracker::setReference(float frequency, float confidence) {
+    if (frequency <= 0) {
+        reset();
+        return;
+    }
+    this->confidence = confidence;
+    if (tableFrequency <= 0 ||
+        fabsf(1200 * log2f(frequency / tableFrequency)) > TRACK_RETUNE_CENTS)
+        buildTables(frequency);
+}
+
+/**
+ * Stop tracking until the next reference, starting over from the newest input then
+ */
+void PhaseTracker::reset() {
+    tableFrequency = 0;
+    nextFrame = -1;
+}
+
+/**
+ * Get the time between tracked pitches
+ * @return Number of frames per hop
+ */
+int PhaseTracker::getHopFrames() const {
+    return hopFrames;
+}
+
+/**
+ * Get the length of the window the current pitch is measured with
+ * @return Number of frames per window (0 before the first reference)
+ */
+int PhaseTracker::getWindowFrames() const {
+    return windowFrames;
+}
+
+/**
+ * Build the window and oscillator tables for a pitch
+ * @param frequency Coarse pitch in hertz
+ */
+void PhaseTracker::buildTables(float frequency) {
+    tableFrequency = frequency;
+    windowFrames = std::min(maxWindow, (int) lroundf(TRACK_PERIODS * sampleRate / frequency));
+
+    // Oscillators are rotated in double precision, so they stay exact over the window
+    for (int h = 1; h <= TRACK_HARMONICS; h++) {
+        double step = 2 * PI * h * frequency / sampleRate;
+        bool audible = h * frequency < sampleRate / 2.0f;
+        double re = 1, im = 0;
+        double stepRe = cos(step), stepIm = sin(step);
+        float *dst = table + (h - 1) * 2;
+        for (int n = 0; n < windowFrames; n++) {
+            double w = audible ? 0.5 - 0.5 * cos(2 * PI * (n + 0.5) / windowFrames) : 0;
+            dst[n * TRACK_HARMONICS * 2] = (float) (w * re);
+            dst[n * TRACK_HARMONICS * 2 + 1] = (float) (-w * im);
+            double next = re * stepRe - im * stepIm;
+            im = re * stepIm + im * stepRe;
+            re = next;
+        }
+    }
+}
+
+/**
+ * Record the tracked pitch of every hop ending in a buffer that hasn't been recorded yet
+ * Each call measures the hop before its first one again from the same buffer, so results
+ * don't depend on how the buffer lined up with the previous call's.
+ * @param samples Analyzed buffer
+ * @param numFrames Number of samples in the buffer
+ * @param endFrame Absolute frame number just past the end of the buffer
+ * @param history History the pitches are added to, timestamped with the end of each window
+ * @return Number of pitches added
+ */
+int PhaseTracker::process(const float *samples, int numFrames, int64_t endFrame,
+                          PitchHistory &history) {
+    if (tableFrequency <= 0 || windowFrames + hopFrames > numFrames)
+        return 0;
+
+    // Start from the newest hop after a reset, and skip hops that have left the buffer
+    int64_t startFrame = endFrame - numFrames;
+    if (nextFrame < 0)
+        nextFrame = endFrame;
+    nextFrame = std::max(nextFrame, startFrame + windowFrames + hopFrames);
+
+    float prevPhases[TRACK_HARMONICS], phases[TRACK_HARMONICS], magnitudes[TRACK_HARMONICS];
+    bool measured = false;
+    int count = 0;
+    for (; nextFrame <= endFrame; nextFrame += hopFrames) {
+        const float *window = samples + (nextFrame - windowFrames - startFrame);
+        if (!measured) {
+            measure(window - hopFrames, prevPhases, magnitudes);
+            measured = true;
+        }
+        measure(window, phases, magnitudes);
+        float frequency = refine(prevPhases, phases, magnitudes);
+        std::copy(phases, phases + TRACK_HARMONICS, prevPhases);
+        if (frequency > 0) {
+            history.add((double) nextFrame / sampleRate, frequency, confidence);
+            count++;
+        }
+    }
+    return count;
+}
+
+/**
+ * Evaluate the DFT of a window at each harmonic of the table pitch
+ * @param window First sample of the window
+ * @param phases Phase of each harmonic (radians)
+ * @param magnitudes Magnitude of each harmonic
+ */
+void PhaseTracker::measure(const float *window, float *phases, float *magnitudes) const {
+    // One pass over the window accumulates every harmonic, which vectorizes across them
+    float sums[TRACK_HARMONICS * 2] = {};
+    for (int n = 0; n < windowFrames; n++) {
+        const float *t = table + n * TRACK_HARMONICS * 2;
+        float x = window[n];
+        for (int k = 0; k < TRACK_HARMONICS * 2; k++)
+            sums[k] += x * t[k];
+    }
+    for (int h = 0; h < TRACK_HARMONICS; h++) {
+        phases[h] = atan2f(sums[h * 2 + 1], sums[h * 2]);
+        magnitudes[h] = hypotf(sums[h * 2], sums[h * 2 + 1]);
+    }
+}
+
+/**
+ * Turn each harmonic's phase advance over a hop into the fundamental
+ * @param prevPhases Phases one hop earlier
+ * @param phases Current phases
+ * @param magnitudes Current magnitudes
+ * @return Fundamental in hertz (average of the harmonics weighted by magnitude), or 0 if
+ *         nothing was measured
+ */
+float PhaseTracker::refine(const float *prevPhases, const float *phases,
+                           const float *magnitudes) const {
+    float strongest = *std::max_element(magnitudes, magnitudes + TRACK_HARMONICS);
+    if (strongest <= 0)
+        return 0;
+
+    double weighted = 0, weights = 0;
+    for (int h = 1; h <= TRACK_HARMONICS; h++) {
+        float magnitude = magnitudes[h - 1];
+        if (magnitude < strongest * TRACK_MIN_LEVEL)
+            continue;
+
+        // Phase advance beyond what the table pitch predicts, wrapped to +-pi
+        double expected = 2 * PI * h * tableFrequency * hopFrames / sampleRate;
+        double deviation = phases[h - 1] - prevPhases[h - 1] - expected;
+        deviation -= 2 * PI * floor(deviation / (2 * PI) + 0.5);
+
+        double harmonic = h * tableFrequency + deviation * sampleRate / (2 * PI * hopFrames);
+        weighted += magnitude * harmonic / h;
+        weights += magnitude;
+    }
+    return weights > 0 ? (float) (weighted / weights) : 0;
+}
@@ -0,0 +1,69 @@
+#ifndef TUNEBLOB_PHASETRACKER_H
+#define TUNEBLOB_PHASETRACKER_H
+
+#include <cstdint>
+#include "PitchHistory.h"
+
+/**
+ * High-rate pitch tracking by phase vocoder refinement of a coarse pitch
+ * Every tracking hop, the coarse pitch's harmonics are measured with a Hann window a few
+ * periods long. How far each harmonic's phase advanced since the previous hop, beyond what
+ * the coarse pitch predicts, gives its exact frequency. Only one DFT bin per harmonic is
+ * evaluated per hop, so this costs a fraction of running the full detector at the same rate.
+ * Runs on the analysis thread over the engine's filtered buffer.
+ */
+class PhaseTracker {
+public:
+
+    PhaseTracker(int sampleRate, int maxWindow);
+    ~PhaseTracker();
+
+    void setReference(float frequency, float confidence);
+    void reset();
+    int process(const float *samples, int numFrames, int64_t endFrame, PitchHistory &history);
+    int getHopFrames() const;
+    int getWindowFrames() const;
+
+private:
+
+    void buildTables(float frequency);
+    void measure(const float *window, float *phases, float *magnitudes) const;
+    float refine(const float *prevPhases, const float *phases, const float *magnitudes) const;
+
+    const int sampleRate;
+    const int maxWindow;
+    const int hopFrames;
+    float *table;           // Hann windowed (cos, -sin) of each harmonic per window sample
+    int windowFrames = 0;
+    float tableFrequency = 0;   // Pitch the tables were built for, or 0 when not tracking
+    float confidence = 0;
+    int64_t nextFrame = -1;     // Absolute frame ending the next hop's window
+};
+
+/**
+ * Number of harmonics measured per hop
+ */
+static const int TRACK_HARMONICS = 4;
+
+/**
+ * Time between tracked pitches
+ */
+static const float TRACK_HOP_SECONDS = 0.0025f;
+
+/**
+ * Periods of the coarse pitch in each window, which keeps the harmonics apart in frequency
+ */
+static const float TRACK_PERIODS = 4;
+
+/**
+ * Coarse pitch changes smaller than this keep the current tables (and window length)
+ */
+static const float TRACK_RETUNE_CENTS = 20;
+
+/**
+ * Harmonics weaker than this relative to the strongest one are left out of the estimate
+ */
+static const float TRACK_MIN_LEVEL = 0.05f;
+
+
+#endif //TUNEBLOB_PHASETRACKER_H
@@ -0,0 +1,48 @@
+#include <algorithm>
+#include "PitchHistory.h"
+
+/**
+ * Create an empty history
+ * @param capacity Maximum number of results kept
+ */
+PitchHistory::PitchHistory(int capacity)
+: capacity(capacity), entries(new Entry[capacity]), sequence(0) {
+}
+
+PitchHistory::~PitchHistory() {
+    delete[] entries;
+}
+
+/**
+ * Add a result, overwriting the oldest one once the ring is full
+ * @param time Audio time in seconds
+ * @param frequency Frequency in hertz
+ * @param confidence Strength of the detected period (0 to 1)
+ */
+void PitchHistory::add(double time, float frequency, float confidence) {
+    std::lock_guard<std::mutex> guard(lock);
+    Entry &e = entries[sequence % capacity];
+    e.time = time;
+    e.frequency = frequency;
+    e.confidence = confidence;
+    sequence++;
+}
+
+/**
+ * Copy every result added since a given sequence number, oldest first
+ * Results that have already been overwritten are skipped
+ * @param since Sequence number of the first result wanted, set to the one after the last
+ *              result copied so it can be passed straight to the next call
+ * @param out Output results
+ * @param maxEntries Maximum number of results to copy
+ * @return Number of results copied
+ */
+int PitchHistory::fetch(int64_t &since, Entry *out, int maxEntries) const {
+    std::lock_guard<std::mutex> guard(lock);
+    int64_t first = std::max(since, std::max((int64_t) 0, sequence - capacity));
+    int count = (int) std::min((int64_t) maxEntries, std::max((int64_t) 0, sequence - first));
+    for (int i = 0; i < count; i++)
+        out[i] = entries[(first + i) % capacity];
+    since = first + count;
+    return count;
+}
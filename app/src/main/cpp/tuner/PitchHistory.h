@@ -0,0 +1,46 @@
+#ifndef TUNEBLOB_PITCHHISTORY_H
+#define TUNEBLOB_PITCHHISTORY_H
+
+#include <cstdint>
+#include <mutex>
+
+/**
+ * Fixed-capacity ring of timestamped pitch results
+ * Written by the analysis thread and read in bulk by views, so a slow reader only
+ * loses results once it falls more than a full ring behind
+ */
+class PitchHistory {
+public:
+
+    /**
+     * A single pitch result
+     */
+    struct Entry {
+        double time;        // Audio time of the newest analyzed sample (seconds since start)
+        float frequency;    // Frequency in hertz
+        float confidence;   // Strength of the detected period (0 to 1)
+    };
+    static_assert(sizeof(Entry) == sizeof(double) + 2 * sizeof(float),
+                  "Entries are split field by field into the Java time and value arrays");
+
+    explicit PitchHistory(int capacity);
+    ~PitchHistory();
+
+    void add(double time, float frequency, float confidence);
+    int fetch(int64_t &since, Entry *out, int maxEntries) const;
+
+private:
+
+    const int capacity;
+    Entry *entries;
+    int64_t sequence;
+    mutable std::mutex lock;
+};
+
+/**
+ * Number of results kept by the engine (about 10 seconds at the analysis rate)
+ */
+static const int HISTORY_CAPACITY = 1024;
+
+
+#endif //TUNEBLOB_PITCHHISTORY_H
@@ -1,14 +1,31 @@
 #include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
 #include "SampleBuffer.h"
-#include "../logging_macros.h"
+#include "../data/SampleKernels.h"
+#include "../debug/TrafficCounter.h"
 
 /**
  * Create the sample buffer
  * @param capacity Sample capacity
+ * @param format Storage format (16-bit halves the memory traffic of the buffer)
  */
-SampleBuffer::SampleBuffer(int capacity) : capacity(capacity) {
+SampleBuffer::SampleBuffer(int capacity, Format format) : format(format), capacity(capacity) {
     bufferSize = 0;
-    buffer = new float[capacity];
+    totalFrames = 0;
+    buffer = format == FLOAT ? new float[capacity] : nullptr;
+    buffer16 = format == INT16 ? new int16_t[capacity] : nullptr;
+
+    // Enough summary slots that blocks still in the ring never share one
+    numBlocks = capacity / SUMMARY_BLOCK + 2;
+    numSuperBlocks = capacity / SUMMARY_SUPER_BLOCK + 2;
+    blocks = new BlockSummary[numBlocks];
+    superBlocks = new BlockSummary[numSuperBlocks];
+    for (int i = 0; i < numBlocks; i++)
+        blocks[i].reset(-1);
+    for (int i = 0; i < numSuperBlocks; i++)
+        superBlocks[i].reset(-1);
 }
 
 /**
@@ -16,6 +33,9 @@ SampleBuffer::SampleBuffer(int capacity) : capacity(capacity) {
  */
 SampleBuffer::~SampleBuffer() {
     delete[] buffer;
+    delete[] buffer16;
+    delete[] blocks;
+    delete[] superBlocks;
 }
 
 /**
@@ -24,28 +44,112 @@ SampleBuffer::~SampleBuffer() {
  * @param numFrames Number of samples
  */
 void SampleBuffer::addSamples(const float *samples, int numFrames) {
-    int s = sizeof(float);
-    int pos = std::max(std::min(bufferSize, capacity - numFrames), 0);
-    int amount = std::min(numFrames, capacity);
-    int shift = std::max((bufferSize + numFrames) - capacity, 0);
+    append(samples, numFrames);
+}
+
+/**
+ * Add 16-bit samples to the buffer
+ * @param samples Array of samples to add
+ * @param numFrames Number of samples
+ */
+void SampleBuffer::addSamples(const int16_t *samples, int numFrames) {
+    append(samples, numFrames);
+}
+
+/**
+ * Copy the current buffer data, oldest sample first, converted to floats
+ * @param out Output array (must fit the current number of samples)
+ */
+void SampleBuffer::getSamples(float *out) const {
+    int start = (int) ((totalFrames - bufferSize) % capacity);
+    int first = std::min(bufferSize, capacity - start);
+    int second = bufferSize - first;
+    if (format == INT16) {
+        SampleKernels::toFloat(buffer16 + start, out, first);
+        SampleKernels::toFloat(buffer16, out + first, second);
+        COUNT_TRAFFIC((sizeof(int16_t) + sizeof(float)) * bufferSize);
+    } else {
+        memcpy(out, buffer + start, first * sizeof(float));
+        memcpy(out + first, buffer, second * sizeof(float));
+        COUNT_TRAFFIC(2 * sizeof(float) * bufferSize);
+    }
+}
+
+/**
+ * Get the peak amplitude of the samples in the buffer
+ * @return Peak amplitude (0 to 1)
+ */
+float SampleBuffer::getPeakAmplitude() const {
+    return getPeakAmplitude(0, bufferSize);
+}
+
+/**
+ * Get the peak amplitude for a range of samples in the buffer
+ * @param start Start sample (0 = oldest sample in the buffer)
+ * @param count Number of samples
+ * @return Peak amplitude (0 to 1)
+ */
+float SampleBuffer::getPeakAmplitude(int start, int count) const {
+    BlockSummary summary;
+    summarize(start, count, summary);
+    return summary.block < 0 ? 0 : std::max(-summary.min, summary.max);
+}
 
-    // Shift existing data to the beginning of the buffer
-    if (shift > 0)
-        memmove(buffer, buffer + shift, (capacity - shift) * s);
+/**
+ * Get the root mean square level of the samples in the buffer
+ * @return RMS level (0 to 1)
+ */
+float SampleBuffer::getRMS() const {
+    return getRMS(0, bufferSize);
+}
 
-    // Add new samples to the end of the buffer
-    memcpy(buffer + pos, samples, amount * s);
+/**
+ * Get the root mean square level for a range of samples in the buffer
+ * @param start Start sample (0 = oldest sample in the buffer)
+ * @param count Number of samples
+ * @return RMS level (0 to 1)
+ */
+float SampleBuffer::getRMS(int start, int count) const {
+    BlockSummary summary;
+    summarize(start, count, summary);
+    return summary.block < 0 ? 0 : (float) sqrt(summary.sumSquares / count);
+}
 
-    // Update the buffer size
-    bufferSize = std::min(bufferSize + amount, capacity);
+/**
+ * Get a min/max envelope of the buffer decimated to a given width (i.e. for waveform views)
+ * @param min Minimum value of each column
+ * @param max Maximum value of each column
+ * @param width Number of columns
+ */
+void SampleBuffer::getEnvelope(float *min, float *max, int width) const {
+    // Columns narrower than a block can't use the summaries, so scan them directly
+    bool scan = bufferSize < width * SUMMARY_BLOCK;
+    int oldest = (int) ((totalFrames - bufferSize) % capacity);
+    BlockSummary summary;
+    int end = 0;
+    for (int x = 0; x < width; x++) {
+        int start = end;
+        end = (int) ((int64_t) (x + 1) * bufferSize / width);
+        if (scan) {
+            summary.reset(end > start ? 0 : -1);
+            int pos = oldest + start;
+            if (end > start)
+                scanSamples(pos >= capacity ? pos - capacity : pos, end - start, summary, false);
+        } else {
+            summarize(start, end - start, summary, false);
+        }
+        bool empty = summary.block < 0;
+        min[x] = empty ? 0 : summary.min;
+        max[x] = empty ? 0 : summary.max;
+    }
 }
 
 /**
- * Get the current buffer data
- * @return Sample buffer data
+ * Get the format samples are stored in
+ * @return Sample format
  */
-float *SampleBuffer::getSamples() {
-    return buffer;
+SampleBuffer::Format SampleBuffer::getFormat() const {
+    return format;
 }
 
 /**
@@ -61,14 +165,197 @@ int SampleBuffer::getCapacity() const {
  * Once the buffer is filled this will be equal to capacity
  * @return Number of samples
  */
-int SampleBuffer::getNumSamples() {
+int SampleBuffer::getNumSamples() const {
     return bufferSize;
 }
 
+/**
+ * Get the total number of frames added since the buffer was created
+ * Safe to read from other threads while samples are being added
+ * @return Number of frames
+ */
+int64_t SampleBuffer::getTotalFrames() const {
+    return totalFrames;
+}
+
 /**
  * Check if the buffer is filled with samples to capacity
  * @return True if filled
  */
 bool SampleBuffer::isFilled() const {
     return bufferSize == capacity;
-}
\ No newline at end of file
+}
+
+/**
+ * Add samples to the ring and update the block summaries
+ * @param samples Array of samples to add
+ * @param numFrames Number of samples
+ */
+template<typename T>
+void SampleBuffer::append(const T *samples, int numFrames) {
+    // Only the newest samples fit if there are more than the capacity
+    if (numFrames > capacity) {
+        totalFrames += numFrames - capacity;
+        samples += numFrames - capacity;
+        numFrames = capacity;
+    }
+
+    // Add new samples at the write position, wrapping around to the start of the ring
+    int writePos = (int) (totalFrames % capacity);
+    int first = std::min(numFrames, capacity - writePos);
+    storeSamples(samples, writePos, first);
+    storeSamples(samples + first, 0, numFrames - first);
+
+    summarizeBlocks(samples, numFrames);
+
+    totalFrames += numFrames;
+    bufferSize = std::min(bufferSize + numFrames, capacity);
+}
+
+/**
+ * Merge new samples into the summaries of the blocks they fall in
+ * @param samples Samples being added
+ * @param numFrames Number of samples
+ */
+template<typename T>
+void SampleBuffer::summarizeBlocks(const T *samples, int numFrames) {
+    const float scale = sizeof(T) == sizeof(int16_t) ? 1.0f / INT16_SCALE : 1.0f;
+    int64_t frame = totalFrames;
+    int i = 0;
+    while (i < numFrames) {
+        // Split the new samples at block boundaries
+        int64_t block = frame / SUMMARY_BLOCK;
+        int count = (int) std::min((int64_t) numFrames - i, (block + 1) * SUMMARY_BLOCK - frame);
+
+        T lo, hi;
+        SampleKernels::range(samples + i, count, lo, hi);
+        BlockSummary chunk;
+        chunk.block = block;
+        chunk.min = (float) lo * scale;
+        chunk.max = (float) hi * scale;
+        chunk.sumSquares = SampleKernels::sumSquares(samples + i, count);
+
+        // Start over when a slot is reused by a new block
+        BlockSummary &fine = blocks[block % numBlocks];
+        if (fine.block != block)
+            fine.reset(block);
+        fine.add(chunk);
+
+        int64_t superBlock = frame / SUMMARY_SUPER_BLOCK;
+        BlockSummary &coarse = superBlocks[superBlock % numSuperBlocks];
+        if (coarse.block != superBlock)
+            coarse.reset(superBlock);
+        coarse.add(chunk);
+
+        frame += count;
+        i += count;
+    }
+}
+
+/**
+ * Write float samples into the ring, converting if necessary
+ * @param samples Samples to write
+ * @param pos Ring position
+ * @param count Number of samples
+ */
+void SampleBuffer::storeSamples(const float *samples, int pos, int count) {
+    if (format == INT16)
+        SampleKernels::toInt16(samples, buffer16 + pos, count);
+    else
+        memcpy(buffer + pos, samples, count * sizeof(float));
+}
+
+/**
+ * Write 16-bit samples into the ring, converting if necessary
+ * @param samples Samples to write
+ * @param pos Ring position
+ * @param count Number of samples
+ */
+void SampleBuffer::storeSamples(const int16_t *samples, int pos, int count) {
+    if (format == INT16)
+        memcpy(buffer16 + pos, samples, count * sizeof(int16_t));
+    else
+        SampleKernels::toFloat(samples, buffer + pos, count);
+}
+
+/**
+ * Summarize a range of samples using whole block summaries where possible
+ * Only the partial blocks at either end of the range are scanned sample by sample
+ * @param start Start sample (0 = oldest sample in the buffer)
+ * @param count Number of samples
+ * @param out Summary output (block is -1 if the range is empty)
+ * @param squares False to skip the sum of squares when scanning (only min/max are needed)
+ */
+void SampleBuffer::summarize(int start, int count, BlockSummary &out, bool squares) const {
+    out.reset(-1);
+    start = std::max(start, 0);
+    count = std::min(count, bufferSize - start);
+    if (count <= 0)
+        return;
+
+    int64_t frame = totalFrames - bufferSize + start;
+    int64_t end = frame + count;
+    while (frame < end) {
+        if (frame % SUMMARY_SUPER_BLOCK == 0 && frame + SUMMARY_SUPER_BLOCK <= end) {
+            out.add(superBlocks[(frame / SUMMARY_SUPER_BLOCK) % numSuperBlocks]);
+            frame += SUMMARY_SUPER_BLOCK;
+        } else if (frame % SUMMARY_BLOCK == 0 && frame + SUMMARY_BLOCK <= end) {
+            out.add(blocks[(frame / SUMMARY_BLOCK) % numBlocks]);
+            frame += SUMMARY_BLOCK;
+        } else {
+            int n = (int) std::min(end, (frame / SUMMARY_BLOCK + 1) * SUMMARY_BLOCK) - (int) frame;
+            scanSamples((int) (frame % capacity), n, out, squares);
+            frame += n;
+        }
+    }
+    out.block = 0;
+}
+
+/**
+ * Scan raw samples from the ring into a summary
+ * @param pos Ring position of the first sample
+ * @param count Number of samples
+ * @param out Summary to add to
+ * @param squares False to skip the sum of squares
+ */
+void SampleBuffer::scanSamples(int pos, int count, BlockSummary &out, bool squares) const {
+    while (count > 0) {
+        int n = std::min(count, capacity - pos);
+        BlockSummary chunk;
+        chunk.block = 0;
+        if (format == INT16) {
+            int16_t lo, hi;
+            SampleKernels::range(buffer16 + pos, n, lo, hi);
+            chunk.min = (float) lo / INT16_SCALE;
+            chunk.max = (float) hi / INT16_SCALE;
+            chunk.sumSquares = squares ? SampleKernels::sumSquares(buffer16 + pos, n) : 0;
+        } else {
+            SampleKernels::range(buffer + pos, n, chunk.min, chunk.max);
+            chunk.sumSquares = squares ? SampleKernels::sumSquares(buffer + pos, n) : 0;
+        }
+        out.add(chunk);
+        count -= n;
+        pos = 0;
+    }
+}
+
+/**
+ * Clear a summary for a new block
+ * @param block Block number
+ */
+void SampleBuffer::BlockSummary::reset(int64_t block) {
+    this->block = block;
+    min = FLT_MAX;
+    max = -FLT_MAX;
+    sumSquares = 0;
+}
+
+/**
+ * Merge another summary into this one
+ * @param other Summary to merge
+ */
+void SampleBuffer::BlockSummary::add(const BlockSummary &other) {
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+    sumSquares += other.sumSquares;
+}
@@ -1,28 +1,83 @@
 #ifndef TUNEBLOB_SAMPLEBUFFER_H
 #define TUNEBLOB_SAMPLEBUFFER_H
 
+#include <atomic>
+#include <cstdint>
+
 /**
  * FIFO sample buffer
+ * Samples are kept in a ring and stored either as floats or 16-bit integers.
+ * A min/max/sum-of-squares summary is kept per 64 and 1024 frame block so level and
+ * waveform overview queries scale with the number of blocks instead of samples.
  */
 class SampleBuffer {
 public:
 
-    SampleBuffer(int capacity);
+    /**
+     * The format samples are stored in
+     */
+    enum Format {
+        FLOAT,
+        INT16
+    };
+
+    SampleBuffer(int capacity, Format format = FLOAT);
     ~SampleBuffer();
 
     void addSamples(const float *samples, int numFrames);
-    float *getSamples();
+    void addSamples(const int16_t *samples, int numFrames);
+    void getSamples(float *out) const;
+    float getPeakAmplitude() const;
+    float getPeakAmplitude(int start, int count) const;
+    float getRMS() const;
+    float getRMS(int start, int count) const;
+    void getEnvelope(float *min, float *max, int width) const;
+    Format getFormat() const;
     int getCapacity() const;
-    int getNumSamples();
+    int getNumSamples() const;
+    int64_t getTotalFrames() const;
     bool isFilled() const;
 
 private:
 
+    /**
+     * Summary of a block of samples
+     */
+    struct BlockSummary {
+        int64_t block;
+        float min;
+        float max;
+        double sumSquares;
+
+        void reset(int64_t block);
+        void add(const BlockSummary &other);
+    };
+
+    template<typename T> void append(const T *samples, int numFrames);
+    template<typename T> void summarizeBlocks(const T *samples, int numFrames);
+    void storeSamples(const float *samples, int pos, int count);
+    void storeSamples(const int16_t *samples, int pos, int count);
+    void summarize(int start, int count, BlockSummary &out, bool squares = true) const;
+    void scanSamples(int pos, int count, BlockSummary &out, bool squares) const;
+
+    const Format format;
     int capacity;
     int bufferSize;
+    std::atomic<int64_t> totalFrames;
     float *buffer;
+    int16_t *buffer16;
+
+    int numBlocks, numSuperBlocks;
+    BlockSummary *blocks;
+    BlockSummary *superBlocks;
 
 };
 
+/**
+ * Frames per summary block (fine and coarse levels)
+ */
+static const int SUMMARY_BLOCK = 64;
+static const int SUMMARY_SUPER_BLOCK = 1024;
+
 
 #endif //TUNEBLOB_SAMPLEBUFFER_H
@@ -0,0 +1,201 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+#include "StrobeEngine.h"
+#include "../data/SampleKernels.h"
+#include "../PI.h"
+
+/**
+ * Create a strobe engine with no reference (idle)
+ * @param sampleRate Input sample rate
+ * @param capacity Number of frames kept for readers
+ */
+StrobeEngine::StrobeEngine(int sampleRate, int capacity)
+: sampleRate(sampleRate), capacity(capacity), reference(0), frameRate(0), active(0),
+  tracking(false), frameLength(0), framePos(0), written(0) {
+    phase = new double[STROBE_HARMONICS];
+    osc = new double[STROBE_HARMONICS * 2];
+    step = new double[STROBE_HARMONICS * 2];
+    sum = new double[STROBE_HARMONICS * 2];
+    frames = new float[capacity * STROBE_FRAME_VALUES];
+}
+
+StrobeEngine::~StrobeEngine() {
+    delete[] phase;
+    delete[] osc;
+    delete[] step;
+    delete[] sum;
+    delete[] frames;
+}
+
+/**
+ * Set the reference frequency (i.e. the target note from the tuning standard)
+ * Takes effect at the end of the current frame
+ * @param frequency Reference frequency in hertz, or 0 to stop tracking
+ */
+void StrobeEngine::setReference(float frequency) {
+    reference = frequency;
+}
+
+/**
+ * Get the reference frequency
+ * @return Frequency in hertz (0 if idle)
+ */
+float StrobeEngine::getReference() const {
+    return reference;
+}
+
+/**
+ * Get how often frames are produced for the current reference
+ * @return Frames per second (0 if idle)
+ */
+float StrobeEngine::getFrameRate() const {
+    return frameRate;
+}
+
+/**
+ * Track a block of float input
+ * @param samples Sample data
+ * @param numFrames Number of samples
+ */
+void StrobeEngine::process(const float *samples, int numFrames) {
+    mix(samples, numFrames);
+}
+
+/**
+ * Track a block of 16-bit input
+ * @param samples Sample data
+ * @param numFrames Number of samples
+ */
+void StrobeEngine::process(const int16_t *samples, int numFrames) {
+    mix(samples, numFrames);
+}
+
+/**
+ * Mix a block of input against the reference oscillators
+ * Runs on the real-time audio thread: no locks, allocations or blocking calls
+ * @param samples Sample data
+ * @param numFrames Number of samples
+ */
+template<typename T>
+void StrobeEngine::mix(const T *samples, int numFrames) {
+    if (active != reference.load(std::memory_order_relaxed))
+        configure(reference);
+    if (!tracking)
+        return;
+
+    const float scale = std::is_same<T, int16_t>::value ? 1.0f / INT16_SCALE : 1.0f;
+    for (int i = 0; i < numFrames; i++) {
+        double x = samples[i] * scale;
+        for (int h = 0; h < STROBE_HARMONICS; h++) {
+            double re = osc[h * 2], im = osc[h * 2 + 1];
+            sum[h * 2] += x * re;
+            sum[h * 2 + 1] -= x * im;
+            osc[h * 2] = re * step[h * 2] - im * step[h * 2 + 1];
+            osc[h * 2 + 1] = re * step[h * 2 + 1] + im * step[h * 2];
+        }
+        if (++framePos == frameLength) {
+            finishFrame();
+
+            // Reference changes are picked up between frames
+            if (active != reference.load(std::memory_order_relaxed)) {
+                configure(reference);
+                if (!tracking)
+                    return;
+            }
+        }
+    }
+}
+
+/**
+ * Restart the oscillators at a new reference frequency
+ * @param frequency Reference frequency in hertz (0 to go idle)
+ */
+void StrobeEngine::configure(float frequency) {
+    active = frequency;
+    framePos = 0;
+
+    // Every harmonic has to fit under the Nyquist frequency
+    tracking = frequency > 0 && frequency * STROBE_HARMONICS < sampleRate / 2;
+    if (!tracking) {
+        frameRate = 0;
+        return;
+    }
+
+    // Integrate over whole reference periods so the mixer's sum frequencies (and the
+    // other harmonics) land on the integrator's nulls
+    int period = std::max(1, (int) lround(sampleRate / frequency));
+    int periods = std::max(1, (int) ceil(sampleRate / STROBE_MAX_FRAME_RATE / period));
+    frameLength = period * periods;
+    frameRate = (float) sampleRate / frameLength;
+
+    for (int h = 0; h < STROBE_HARMONICS; h++) {
+        double delta = 2 * PI * frequency * (h + 1) / sampleRate;
+        phase[h] = 0;
+        osc[h * 2] = 1;
+        osc[h * 2 + 1] = 0;
+        step[h * 2] = cos(delta);
+        step[h * 2 + 1] = sin(delta);
+        sum[h * 2] = sum[h * 2 + 1] = 0;
+    }
+}
+
+/**
+ * Publish the phase and amplitude of each harmonic and start the next frame
+ */
+void StrobeEngine::finishFrame() {
+    int64_t sequence = written.load(std::memory_order_relaxed);
+    float *frame = frames + (sequence % capacity) * STROBE_FRAME_VALUES;
+    for (int h = 0; h < STROBE_HARMONICS; h++) {
+        double re = sum[h * 2], im = sum[h * 2 + 1];
+        frame[h * 2] = (float) atan2(im, re);
+        frame[h * 2 + 1] = (float) (2 * sqrt(re * re + im * im) / frameLength);
+        sum[h * 2] = sum[h * 2 + 1] = 0;
+
+        // Reseed the oscillator from the exact phase so rounding in the rotation never
+        // builds up into a frequency error
+        double cycles = (double) active * (h + 1) * frameLength / sampleRate;
+        phase[h] = fmod(phase[h] + cycles, 1.0);
+        osc[h * 2] = cos(2 * PI * phase[h]);
+        osc[h * 2 + 1] = sin(2 * PI * phase[h]);
+    }
+    framePos = 0;
+    written.store(sequence + 1, std::memory_order_release);
+}
+
+/**
+ * Copy every frame produced since a given sequence number, oldest first
+ * Each frame is STROBE_FRAME_VALUES floats: phase (radians) and amplitude of each harmonic
+ * Frames that have already been overwritten are skipped
+ * @param since Sequence number of the first frame wanted, set to the one after the last
+ *              frame copied (a number past the end, i.e. from an earlier engine, starts over)
+ * @param out Output frames
+ * @param maxFrames Maximum number of frames to copy
+ * @return Number of frames copied
+ */
+int StrobeEngine::fetch(int64_t &since, float *out, int maxFrames) const {
+    int64_t end = written.load(std::memory_order_acquire);
+    if (since > end)
+        since = 0;
+
+    // The slot after the newest frame may be mid-write
+    int64_t first = std::max(since, std::max((int64_t) 0, end - capacity + 1));
+    int count = (int) std::min((int64_t) maxFrames, end - first);
+    for (int i = 0; i < count; i++)
+        memcpy(out + i * STROBE_FRAME_VALUES,
+               frames + ((first + i) % capacity) * STROBE_FRAME_VALUES,
+               STROBE_FRAME_VALUES * sizeof(float));
+
+    // Drop any frames the audio thread overwrote while they were being copied
+    int64_t oldest = written.load(std::memory_order_acquire) - capacity + 1;
+    int torn = (int) std::min((int64_t) count, std::max((int64_t) 0, oldest - first));
+    if (torn > 0) {
+        count -= torn;
+        memmove(out, out + torn * STROBE_FRAME_VALUES, count * STROBE_FRAME_VALUES * sizeof(float));
+        first += torn;
+    }
+
+    since = first + count;
+    return count;
+}
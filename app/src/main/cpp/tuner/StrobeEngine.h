@@ -0,0 +1,75 @@
+#ifndef TUNEBLOB_STROBEENGINE_H
+#define TUNEBLOB_STROBEENGINE_H
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * Strobe tuner phase tracker
+ * Mixes the input down against a reference oscillator at each of the first few harmonics of
+ * the target note and integrates each mix over whole reference periods. Every frame gives
+ * the phase and amplitude of each harmonic relative to the reference, so an in-tune input
+ * holds still and a sharp or flat one rotates at the frequency difference.
+ * Runs on the audio thread; frames are kept in a ring that views read without locking.
+ */
+class StrobeEngine {
+public:
+
+    StrobeEngine(int sampleRate, int capacity);
+    ~StrobeEngine();
+
+    void setReference(float frequency);
+    float getReference() const;
+    void process(const float *samples, int numFrames);
+    void process(const int16_t *samples, int numFrames);
+    int fetch(int64_t &since, float *out, int maxFrames) const;
+    float getFrameRate() const;
+
+private:
+
+    template<typename T> void mix(const T *samples, int numFrames);
+    void configure(float frequency);
+    void finishFrame();
+
+    const int sampleRate;
+    const int capacity;
+    std::atomic<float> reference;
+    std::atomic<float> frameRate;
+
+    // Only used by the audio thread
+    float active;
+    bool tracking;
+    int frameLength;
+    int framePos;
+    double *phase;      // Oscillator phase at the start of the frame (cycles)
+    double *osc;        // Oscillator phasor (re, im per harmonic)
+    double *step;       // Phasor rotation per sample (re, im per harmonic)
+    double *sum;        // Mixed and integrated input (re, im per harmonic)
+
+    float *frames;
+    std::atomic<int64_t> written;
+};
+
+/**
+ * Number of harmonics tracked
+ */
+static const int STROBE_HARMONICS = 4;
+
+/**
+ * Values per frame (phase and amplitude of each harmonic)
+ */
+static const int STROBE_FRAME_VALUES = STROBE_HARMONICS * 2;
+
+/**
+ * Frames are at least one reference period long, and as many more as it takes to stay
+ * under this rate
+ */
+static const float STROBE_MAX_FRAME_RATE = 500;
+
+/**
+ * Number of frames kept by the engine (at least a second at the highest frame rate)
+ */
+static const int STROBE_CAPACITY = 512;
+
+
+#endif //TUNEBLOB_STROBEENGINE_H
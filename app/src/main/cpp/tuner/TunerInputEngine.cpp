@@ -1,4 +1,9 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <thread>
 #include "TunerInputEngine.h"
+#include "../debug/RealtimeGuard.h"
 #include "../logging_macros.h"
 
 /**
@@ -6,9 +11,10 @@
  * @param bufferSize Buffer size in seconds
  * @param minAmp Minimum amplitude
  * @param maxFreq Maximum frequency
+ * @param int16Input True to read 16-bit input instead of floats (cheaper on low-end devices)
  * @return True if parameters were set successfully
  */
-bool TunerInputEngine::setParameters(float bufferSize, float minAmp, float maxFreq) {
+bool TunerInputEngine::setParameters(float bufferSize, float minAmp, float maxFreq, bool int16Input) {
 
     // Engine cannot be running when this call is made
     if (running) {
@@ -19,54 +25,83 @@ bool TunerInputEngine::setParameters(float bufferSize, float minAmp, float maxFr
     this->bufferSize = bufferSize;
     this->minAmp = minAmp;
     this->maxFreq = maxFreq;
+    this->int16Input = int16Input;
     return true;
 }
 
 /**
- * Start the tuner engine, which continuously reads audio samples from a given input device
- * @param deviceId Audio input device ID
- * @param channels Number of channels used by the input
- * @param sampleRate Sample rate of the input
- * @return Success result
+ * Start the tuner engine, which continuously reads audio samples from an input source
+ * @param source Input source (i.e. an audio device)
+ * @return 0 on success, or the source's error code
  */
-oboe::Result TunerInputEngine::start(int deviceId, int channels, int sampleRate) {
+int TunerInputEngine::start(const std::shared_ptr<InputSource> &source) {
 
     std::lock_guard<std::mutex> lock(mLock);
 
     // No need to start when we're already running
     if (running)
-        return oboe::Result::OK;
+        return 0;
+
+    int result = source->open(this, int16Input ? SampleBuffer::INT16 : SampleBuffer::FLOAT);
+    if (result != 0)
+        return result;
 
+    int sampleRate = source->getSampleRate();
     int bufferSize = (int) (this->bufferSize * (float) sampleRate);
 
-    sampleBuffer = std::make_shared<SampleBuffer>(bufferSize);
-    freqReader = std::make_shared<FrequencyReader>(sampleRate, this->minAmp);
-    lowPass = std::make_shared<BiQuadFilter>(BiQuadFilter::LOW_PASS, BiQuadFilter::EIGHT, maxFreq);
-
-    // Create the Oboe stream listener
-    oboe::AudioStreamBuilder builder;
-    oboe::Result result = builder.setDeviceId(deviceId)
-            ->setChannelCount(channels)
-            ->setSampleRate(sampleRate)
-            ->setSharingMode(oboe::SharingMode::Exclusive)
-            ->setDirection(oboe::Direction::Input)
-            ->setPerformanceMode(oboe::PerformanceMode::LowLatency)
-            ->setSampleRateConversionQuality(oboe::SampleRateConversionQuality::Medium)
-            ->setFormat(oboe::AudioFormat::Float)
-            ->setDataCallback(this)
-            ->openStream(mStream);
-
-    if (result != oboe::Result::OK)
-        return result;
+    // Build everything the callback and analysis need before the source can call back
+    auto *s = new Session();
+
+    // Analyze high sample rates at 44.1 or 48 kHz, so the window keeps the same duration
+    // and FFT size instead of growing with the rate
+    s->decimator = std::make_shared<Decimator>(sampleRate, MIN_ANALYSIS_RATE, bufferSize);
+    int factor = s->decimator->getFactor();
+    int analysisRate = s->decimator->getOutputRate();
+    s->freqReader = std::make_shared<FrequencyReader>(analysisRate, this->minAmp);
+    // Let the power spectrum catch octave errors on bass notes with weak fundamentals
+    s->freqReader->setDetector(FrequencyReader::FUSED);
+    // Once a pitch is found, higher notes are analyzed with smaller windows of newer input
+    s->freqReader->setAdaptiveWindow(true);
+    s->hopFrames = s->freqReader->getWindowSize() / 2 * factor;
+    s->nextHop = s->hopFrames;
+
+    // Close the gate once the input has been quiet for about one analysis window
+    s->gate = std::make_shared<LevelGate>(minAmp, minAmp * GATE_HYSTERESIS, bufferSize / 4);
+    s->changes = std::make_shared<ChangeDetector>((int) (CHANGE_WINDOW_SECONDS * sampleRate),
+                                                  minAmp * GATE_HYSTERESIS);
+    s->lowPass = std::make_shared<BiQuadFilter>(BiQuadFilter::LOW_PASS, BiQuadFilter::EIGHT, maxFreq);
+
+    // Store samples in the format the source actually delivers so the callback never converts
+    s->sampleBuffer = std::make_shared<SampleBuffer>(bufferSize, source->getFormat());
+    s->wav = std::make_shared<WavData>(1, bufferSize, sampleRate, new float[bufferSize], true);
+    s->snapshot = std::make_shared<WavData>(1, bufferSize, sampleRate, new float[bufferSize], true);
+    s->snapshotFilter = std::make_shared<BiQuadFilter>(BiQuadFilter::LOW_PASS, BiQuadFilter::EIGHT, maxFreq);
+    s->strobe = std::make_shared<StrobeEngine>(sampleRate, STROBE_CAPACITY);
+    s->strobe->setReference(strobeReference);
+    if (factor > 1) {
+        int analysisFrames = bufferSize / factor;
+        s->analysisWav = std::make_shared<WavData>(1, analysisFrames, analysisRate,
+                                                   new float[analysisFrames], true);
+    } else {
+        s->analysisWav = s->wav;
+    }
+    if (tracking)
+        s->tracker = std::make_shared<PhaseTracker>(analysisRate, s->analysisWav->numFrames / 2);
 
-    // Start the stream
-    result = mStream->requestStart();
+    // Hand the session over to the callback and analysis
+    latestFrequency = 0;
+    session = s;
+    running = true;
+    this->source = source;
+    scheduler->add(this);
 
-    // If all went well then initialize the wav container and flag as running
-    if (result == oboe::Result::OK) {
-        this->wav = std::make_shared<WavData>(channels, bufferSize,sampleRate,
-                                              new float[bufferSize], true);
-        this->running = true;
+    // Start the input
+    result = source->start();
+    if (result != 0) {
+        running = false;
+        source->stop();
+        this->source.reset();
+        closeSession();
     }
 
     return result;
@@ -74,63 +109,381 @@ oboe::Result TunerInputEngine::start(int deviceId, int channels, int sampleRate)
 
 /**
  * Stop the tuner engine
- * @return Success result
+ * @return 0 on success, or the source's error code
  */
-oboe::Result TunerInputEngine::stop() {
-    oboe::Result result = oboe::Result::OK;
+int TunerInputEngine::stop() {
+    int result = 0;
     std::lock_guard<std::mutex> lock(mLock);
     if (running) {
-        result = mStream->stop();
-        mStream->close();
-        mStream.reset();
         running = false;
+        result = source->stop();
+        source.reset();
+        closeSession();
     }
     return result;
 }
 
 /**
- * Called whenever a new batch is samples have been received from the input device
- * @param oboeStream Audio stream instance
- * @param inputData Audio sample data
+ * Take the session back from the input callback and analysis job and free it
+ * Must be called with mLock held
+ */
+void TunerInputEngine::closeSession() {
+    // Wait for any analysis that's still using the buffers
+    scheduler->remove(this);
+
+    // A callback that loaded the session before the exchange is counted, so wait for it
+    Session *s = session.exchange(nullptr);
+    while (callbacks.load() != 0)
+        std::this_thread::yield();
+    delete s;
+
+    RealtimeGuard::report();
+}
+
+/**
+ * Called whenever a new block of float samples has been received from the input source
+ * @param samples Sample data
  * @param numFrames Number of samples
  * @return Whether to continue listening or stop
  */
-oboe::DataCallbackResult
-TunerInputEngine::onAudioReady(oboe::AudioStream *oboeStream, void *inputData, int32_t numFrames) {
+bool TunerInputEngine::onInput(const float *samples, int numFrames) {
+    return process(samples, numFrames);
+}
+
+/**
+ * Called whenever a new block of 16-bit samples has been received from the input source
+ * @param samples Sample data
+ * @param numFrames Number of samples
+ * @return Whether to continue listening or stop
+ */
+bool TunerInputEngine::onInput(const int16_t *samples, int numFrames) {
+    return process(samples, numFrames);
+}
+
+/**
+ * Buffer a block of input and queue an analysis when a hop is complete
+ * Runs on the real-time audio thread for device sources: no locks, allocations or blocking calls
+ * @param samples Sample data
+ * @param numFrames Number of samples
+ * @return Whether to continue listening or stop
+ */
+template<typename T>
+bool TunerInputEngine::process(const T *samples, int numFrames) {
+
+    // Register before loading the session so stop() can't free it underneath us
+    callbacks++;
+    Session *s = session.load();
+    if (s == nullptr) {
+        callbacks--;
+        return false;
+    }
+
+    // Track the level of each block so silence can skip analysis entirely
+    s->gate->process(samples, numFrames);
+    s->sampleBuffer->addSamples(samples, numFrames);
+    s->strobe->process(samples, numFrames);
+
+    // A jump or drop in level is a new note or a change in dynamics, so the next hop is
+    // analyzed whatever the stride and the analysis goes back to every hop
+    if (s->changes->process(samples, numFrames)) {
+        s->levelChanged.store(true, std::memory_order_relaxed);
+        s->pendingChange = true;
+    }
+
+    // Queue an analysis once another hop of input has arrived, skipping hops while the
+    // pitch holds steady
+    int64_t frames = s->sampleBuffer->getTotalFrames();
+    if (frames >= s->nextHop) {
+        s->nextHop = frames + s->hopFrames;
+        if (++s->strideHops >= s->hopStride.load(std::memory_order_relaxed) || s->pendingChange) {
+            s->strideHops = 0;
+            s->pendingChange = false;
+            scheduler->signal(this);
+        } else {
+            skippedHops.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    callbacks--;
+    return true;
+}
+
+/**
+ * Detect the pitch of the latest input (called on the analysis scheduler)
+ * Results are timestamped with the audio time so views don't depend on their frame rate
+ */
+void TunerInputEngine::runAnalysis() {
+    // The session can't be freed while this job is registered
+    Session *s = session.load();
+    if (s == nullptr)
+        return;
 
-    if (!running)
-        return oboe::DataCallbackResult::Stop;
+    // Nothing to do unless input arrived since the last run
+    int64_t frames = s->sampleBuffer->getTotalFrames();
+    if (frames == s->analyzedFrames)
+        return;
+    s->analyzedFrames = frames;
 
-    const auto *inputFloats = static_cast<const float *>(inputData);
+    float confidence;
+    float frequency = analyzeBuffer(s, &confidence);
+    latestFrequency = frequency;
+    analyzedHops.fetch_add(1, std::memory_order_relaxed);
 
-    sampleBuffer->addSamples(inputFloats, numFrames);
+    // In tracking mode the result only anchors the tracker, which records a pitch for every
+    // tracking hop since the last analysis. It needs every hop analyzed to keep up.
+    if (s->tracker != nullptr) {
+        s->tracker->setReference(frequency, confidence);
+        if (frequency > 0) {
+            WavData *analysisWav = s->analysisWav.get();
+            s->tracker->process(analysisWav->samples, analysisWav->numFrames,
+                                frames / s->decimator->getFactor(), *history);
+        }
+        return;
+    }
 
-    return oboe::DataCallbackResult::Continue;
+    if (adaptiveRate)
+        updateHopStride(s, frequency);
+    if (frequency > 0)
+        history->add((double) frames / s->wav->sampleRate, frequency, confidence);
 }
 
 /**
- * Compute the frequency using the current sample buffer
+ * Lower the analysis rate while the pitch holds steady, and go back to every hop as soon as
+ * it moves, the level changes or the pitch is lost
+ * @param s Running session
+ * @param frequency Latest result
+ */
+void TunerInputEngine::updateHopStride(Session *s, float frequency) {
+    bool changed = s->levelChanged.exchange(false, std::memory_order_relaxed);
+    bool stable = !changed && frequency > 0 && s->stableFrequency > 0 &&
+            fabsf(1200 * log2f(frequency / s->stableFrequency)) <= STABLE_CENTS;
+    if (!stable) {
+        s->stableFrequency = frequency;
+        s->stableHops = 0;
+        s->hopStride.store(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // Double the stride each time the pitch holds for another STABLE_HOPS analyses
+    if (++s->stableHops >= STABLE_HOPS) {
+        s->stableHops = 0;
+        int stride = s->hopStride.load(std::memory_order_relaxed);
+        s->hopStride.store(std::min(stride * 2, MAX_HOP_STRIDE), std::memory_order_relaxed);
+    }
+}
+
+/**
+ * Get the frequency from the latest analysis
  * @return Frequency in hertz
  */
 float TunerInputEngine::queryFrequency() {
+    std::lock_guard<std::mutex> lock(mLock);
+    Session *s = session.load();
+    if (s == nullptr || !s->gate->isOpen())
+        return 0;
+    return latestFrequency;
+}
+
+/**
+ * Copy the pitch results recorded since a given sequence number
+ * @param since Sequence number of the first result wanted (updated to the next one)
+ * @param out Output results
+ * @param maxEntries Maximum number of results to copy
+ * @return Number of results copied
+ */
+int TunerInputEngine::fetchHistory(int64_t &since, PitchHistory::Entry *out, int maxEntries) {
+    return history->fetch(since, out, maxEntries);
+}
+
+/**
+ * Compute the frequency using the current sample buffer
+ * @param s Running session
+ * @param confidence Set to the strength of the detected period
+ * @return Frequency in hertz
+ */
+float TunerInputEngine::analyzeBuffer(Session *s, float *confidence) {
+    *confidence = 0;
+
+    // Input is silent - skip the copy, filter and FFT stages, and start the next note from
+    // the full window instead of the last note's window size
+    if (!s->gate->isOpen()) {
+        s->freqReader->resetTracking();
+        return 0;
+    }
+
     // Sample buffer hasn't been filled yet
+    SampleBuffer *sampleBuffer = s->sampleBuffer.get();
     if (!sampleBuffer->isFilled())
         return 0;
 
+    // The frequency reader rejects the scan if any window it analyzes is too quiet, so check
+    // the raw levels of those windows (the newest ones while it tracks a pitch) using the
+    // block summaries before paying for the copy and filter
+    int factor = s->decimator->getFactor();
+    int numFrames = s->analysisWav->numFrames;
+    int startFrame = 0, scanFrames = numFrames;
+    int windowSize = s->freqReader->getNextScan(numFrames, startFrame, scanFrames);
+    int windows = std::max(1, scanFrames / windowSize);
+    for (int i = 0; i < windows && startFrame + windowSize < numFrames; i++) {
+        if (sampleBuffer->getPeakAmplitude(startFrame * factor, windowSize * factor) < minAmp) {
+            // The reader would have dropped the tracked pitch on this result too
+            s->freqReader->resetTracking();
+            return 0;
+        }
+        startFrame += windowSize;
+    }
+
     // Copy the latest samples into the wav buffer so we don't run into threading issues
-    memcpy(wav->samples, sampleBuffer->getSamples(), sampleBuffer->getCapacity() * sizeof(float));
+    // 16-bit input is converted to floats here, right before filtering
+    WavData *wav = s->wav.get();
+    sampleBuffer->getSamples(wav->samples);
+
+    // Bring high sample rates down first, so the filter runs at the lower rate too
+    WavData *analysisWav = s->analysisWav.get();
+    if (analysisWav != wav)
+        s->decimator->apply(wav->samples, wav->numFrames, analysisWav->samples);
 
     // Apply low pass filter
-    lowPass->apply(wav.get());
+    s->lowPass->apply(analysisWav);
 
     // Get frequency using the frequency detector
-    return freqReader->getFrequency(wav.get(), 0, 0, wav->numFrames);
+    return s->freqReader->getFrequency(analysisWav, 0, 0, analysisWav->numFrames, confidence);
+}
+
+/**
+ * Check if the input is loud enough to be analyzed
+ * While false the analysis thread can drop to a low query rate
+ * @return True if the level gate is open
+ */
+bool TunerInputEngine::isInputActive() {
+    std::lock_guard<std::mutex> lock(mLock);
+    Session *s = session.load();
+    return s != nullptr && s->gate->isOpen();
+}
+
+/**
+ * Get a min/max envelope of the raw input at a given width (i.e. for waveform views)
+ * @param since Input sequence (total frames) the caller last saw (updated when filled)
+ * @param min Minimum value of each column
+ * @param max Maximum value of each column
+ * @param width Number of columns
+ * @return True if the envelope was filled, false if there's no new input or the engine
+ *         isn't running
+ */
+bool TunerInputEngine::getEnvelope(int64_t &since, float *min, float *max, int width) {
+    std::lock_guard<std::mutex> lock(mLock);
+    Session *s = session.load();
+    if (s == nullptr)
+        return false;
+    int64_t frames = s->sampleBuffer->getTotalFrames();
+    if (frames == since)
+        return false;
+    s->sampleBuffer->getEnvelope(min, max, width);
+    since = frames;
+    return true;
+}
+
+/**
+ * Copy the low passed input in the sample buffer, oldest first
+ * The filtered snapshot is only built when asked for, and once per new block of input no
+ * matter how many views share it
+ * @param since Input sequence (total frames) the caller last saw (updated when copied)
+ * @param out Output samples
+ * @param maxFrames Size of the output
+ * @return Number of samples copied (0 if there's no new input, the engine isn't running or
+ *         the output is too small)
+ */
+int TunerInputEngine::getWaveform(int64_t &since, float *out, int maxFrames) {
+    std::lock_guard<std::mutex> lock(mLock);
+    Session *s = session.load();
+    int capacity = s != nullptr ? s->sampleBuffer->getCapacity() : 0;
+    if (s == nullptr || maxFrames < capacity)
+        return 0;
+
+    int64_t frames = s->sampleBuffer->getTotalFrames();
+    if (frames == since)
+        return 0;
+
+    if (frames != s->snapshotFrames) {
+        WavData *snapshot = s->snapshot.get();
+        s->sampleBuffer->getSamples(snapshot->samples);
+        s->snapshotFilter->apply(snapshot);
+        s->snapshotFrames = frames;
+    }
+    std::copy(s->snapshot->samples, s->snapshot->samples + capacity, out);
+    since = frames;
+    return capacity;
+}
+
+/**
+ * Set the reference the strobe tracks the input against (i.e. the target note)
+ * @param frequency Reference frequency in hertz, or 0 to stop the strobe
+ */
+void TunerInputEngine::setStrobeReference(float frequency) {
+    std::lock_guard<std::mutex> lock(mLock);
+    strobeReference = frequency;
+    Session *s = session.load();
+    if (s != nullptr)
+        s->strobe->setReference(frequency);
+}
+
+/**
+ * Copy the strobe frames produced since a given sequence number
+ * @param since Sequence number of the first frame wanted (updated to the next one)
+ * @param out Output frames (STROBE_FRAME_VALUES floats each)
+ * @param maxFrames Maximum number of frames to copy
+ * @return Number of frames copied
+ */
+int TunerInputEngine::fetchStrobe(int64_t &since, float *out, int maxFrames) {
+    std::lock_guard<std::mutex> lock(mLock);
+    Session *s = session.load();
+    if (s == nullptr)
+        return 0;
+    return s->strobe->fetch(since, out, maxFrames);
 }
 
 /**
- * Get the wav data instance that holds the sample buffer
- * @return Wav data
+ * Set whether analysis slows down while the pitch holds steady (on by default)
+ * @param adaptive True to skip hops of a steady pitch, false to analyze every hop
+ * @return True if set (the engine can't be running)
  */
-WavData *TunerInputEngine::getWav() {
-    return wav.get();
-}
\ No newline at end of file
+bool TunerInputEngine::setAdaptiveRate(bool adaptive) {
+    if (running) {
+        LOGE("Cannot setAdaptiveRate while engine is running");
+        return false;
+    }
+    adaptiveRate = adaptive;
+    return true;
+}
+
+/**
+ * Set whether the history records a pitch every TRACK_HOP_SECONDS, refined from each
+ * analysis by the phase tracker, instead of one pitch per analysis (off by default)
+ * Tracking analyzes every hop, and the history holds about 2.5 seconds of results.
+ * @param tracking True for high-rate tracking
+ * @return True if set (the engine can't be running)
+ */
+bool TunerInputEngine::setTracking(bool tracking) {
+    if (running) {
+        LOGE("Cannot setTracking while engine is running");
+        return false;
+    }
+    this->tracking = tracking;
+    return true;
+}
+
+/**
+ * Get the number of hops analyzed since the engine was created
+ * @return Number of analyses
+ */
+int64_t TunerInputEngine::getAnalyzedHops() const {
+    return analyzedHops.load(std::memory_order_relaxed);
+}
+
+/**
+ * Get the number of hops skipped because the pitch was steady since the engine was created
+ * @return Number of skipped hops
+ */
+int64_t TunerInputEngine::getSkippedHops() const {
+    return skippedHops.load(std::memory_order_relaxed);
+}
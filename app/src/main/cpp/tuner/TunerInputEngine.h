@@ -1,43 +1,130 @@
 #ifndef TUNEBLOB_TUNERINPUTENGINE_H
 #define TUNEBLOB_TUNERINPUTENGINE_H
 
-#include <oboe/Oboe.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include "SampleBuffer.h"
+#include "LevelGate.h"
+#include "ChangeDetector.h"
+#include "PitchHistory.h"
+#include "StrobeEngine.h"
+#include "PhaseTracker.h"
 #include "../audacity/FrequencyReader.h"
 #include "../data/WavData.h"
+#include "../data/Decimator.h"
 #include "../biquad/BiQuadFilter.h"
+#include "../thread/AnalysisScheduler.h"
+#include "../input/InputSource.h"
 
 /**
- * Listens on an audio input device and saves samples to a buffer
+ * Listens to an input source and saves samples to a buffer
+ * Every half window of input queues a pitch analysis on the shared scheduler, which records
+ * the result in the history. The engine doesn't depend on where the input comes from, so it
+ * runs the same with an audio device, a file or a generator.
  */
-class TunerInputEngine: public oboe::AudioStreamDataCallback {
+class TunerInputEngine: public InputSource::Listener, public AnalysisJob {
 public:
 
     ~TunerInputEngine() override = default;
 
-    bool setParameters(float bufferSize, float minAmp, float maxFreq);
-    oboe::Result start(int deviceId, int channels, int sampleRate);
-    oboe::Result stop();
-    oboe::DataCallbackResult onAudioReady(oboe::AudioStream *oboeStream, void *audioData, int32_t numFrames) override;
+    bool setParameters(float bufferSize, float minAmp, float maxFreq, bool int16Input);
+    int start(const std::shared_ptr<InputSource> &source);
+    int stop();
+    bool onInput(const float *samples, int numFrames) override;
+    bool onInput(const int16_t *samples, int numFrames) override;
+    void runAnalysis() override;
 
     float queryFrequency();
-    WavData *getWav();
+    int fetchHistory(int64_t &since, PitchHistory::Entry *out, int maxEntries);
+    bool isInputActive();
+    bool getEnvelope(int64_t &since, float *min, float *max, int width);
+    int getWaveform(int64_t &since, float *out, int maxFrames);
+    void setStrobeReference(float frequency);
+    int fetchStrobe(int64_t &since, float *out, int maxFrames);
+    bool setAdaptiveRate(bool adaptive);
+    bool setTracking(bool tracking);
+    int64_t getAnalyzedHops() const;
+    int64_t getSkippedHops() const;
 
 private:
 
+    /**
+     * Everything used while the stream is running
+     * Built by start() and handed to the audio callback and the analysis job through an
+     * atomic pointer. Only stop() frees it, once neither can be using it anymore.
+     */
+    struct Session {
+        std::shared_ptr<WavData> wav;
+        std::shared_ptr<WavData> analysisWav;   // Same as wav unless the input is decimated
+        std::shared_ptr<Decimator> decimator;
+        std::shared_ptr<SampleBuffer> sampleBuffer;
+        std::shared_ptr<LevelGate> gate;
+        std::shared_ptr<ChangeDetector> changes;
+        std::shared_ptr<FrequencyReader> freqReader;
+        std::shared_ptr<BiQuadFilter> lowPass;
+        std::shared_ptr<StrobeEngine> strobe;
+        std::shared_ptr<PhaseTracker> tracker;  // Only in tracking mode
+        int hopFrames = 0;
+        int64_t nextHop = 0;    // Only used by the audio callback
+        int64_t analyzedFrames = -1;    // Only used by the analysis job
+
+        // Hops per analysis, raised by the analysis job while the pitch holds steady
+        std::atomic<int> hopStride{1};
+        std::atomic<bool> levelChanged{false};  // Set by the audio callback, taken by analysis
+        int strideHops = 0;             // Only used by the audio callback
+        bool pendingChange = false;     // Only used by the audio callback
+        float stableFrequency = 0;      // Only used by the analysis job
+        int stableHops = 0;             // Only used by the analysis job
+
+        // Filtered waveform for views, only built when one asks (guarded by mLock)
+        std::shared_ptr<WavData> snapshot;
+        std::shared_ptr<BiQuadFilter> snapshotFilter;
+        int64_t snapshotFrames = -1;
+    };
+
+    template<typename T> bool process(const T *samples, int numFrames);
+    void closeSession();
+    float analyzeBuffer(Session *s, float *confidence);
+    void updateHopStride(Session *s, float frequency);
+
     float bufferSize = 0.2;
     float minAmp = 0.01;
     float maxFreq = 1000;
+    bool int16Input = false;
+    bool adaptiveRate = true;
+    bool tracking = false;
 
-    std::shared_ptr<WavData> wav;
-    std::shared_ptr<SampleBuffer> sampleBuffer;
-    std::shared_ptr<FrequencyReader> freqReader;
-    std::shared_ptr<BiQuadFilter> lowPass;
+    std::shared_ptr<PitchHistory> history = std::make_shared<PitchHistory>(HISTORY_CAPACITY);
+    std::shared_ptr<AnalysisScheduler> scheduler = AnalysisScheduler::getShared();
 
+    // Serializes start, stop and queries (never taken by the audio callback)
     std::mutex         mLock;
-    std::shared_ptr<oboe::AudioStream> mStream;
-    bool running;
+    std::shared_ptr<InputSource> source;
+    std::atomic<Session *> session{nullptr};
+    std::atomic<int> callbacks{0};
+    std::atomic<float> latestFrequency{0};
+    std::atomic<float> strobeReference{0};
+    std::atomic<bool> running{false};
+    std::atomic<int64_t> analyzedHops{0};
+    std::atomic<int64_t> skippedHops{0};
 };
 
+/**
+ * Analyses in a row within STABLE_CENTS of the first one before the hop stride doubles
+ */
+static const int STABLE_HOPS = 4;
+static const float STABLE_CENTS = 3;
+
+/**
+ * Most hops skipped between analyses of a steady pitch, minus one
+ */
+static const int MAX_HOP_STRIDE = 4;
+
+/**
+ * Length of the change detector's level windows (a period of anything down to 50 Hz)
+ */
+static const float CHANGE_WINDOW_SECONDS = 0.02f;
+
 
 #endif //TUNEBLOB_TUNERINPUTENGINE_H
@@ -0,0 +1,48 @@
+package software.blob.audio.tuner.engine
+
+// Matches the capacity of the native history ring
+private const val DEFAULT_CAPACITY = 1024
+
+/**
+ * Reusable buffer for pitch results fetched from the [TunerInputEngine] history
+ * Each fetch continues from where the previous one left off
+ * @param capacity Maximum number of results per fetch
+ */
+class PitchHistory(capacity: Int = DEFAULT_CAPACITY) {
+
+    // Audio times in seconds (double so they stay finer than the tracking hop in long sessions)
+    internal val times = DoubleArray(capacity)
+
+    // Packed (frequency, confidence) pairs
+    internal val values = FloatArray(capacity * 2)
+
+    // Sequence number of the next result to fetch (array so native can update it)
+    internal val sequence = LongArray(1)
+
+    /**
+     * Number of results from the last fetch
+     */
+    var size = 0
+        internal set
+
+    /**
+     * Get the audio time of a result
+     * @param index Result index
+     * @return Seconds since the engine was started
+     */
+    fun time(index: Int) = times[index]
+
+    /**
+     * Get the frequency of a result
+     * @param index Result index
+     * @return Frequency in hertz
+     */
+    fun frequency(index: Int) = values[index * 2].toDouble()
+
+    /**
+     * Get the confidence of a result
+     * @param index Result index
+     * @return Strength of the detected period (0 to 1)
+     */
+    fun confidence(index: Int) = values[index * 2 + 1].toDouble()
+}
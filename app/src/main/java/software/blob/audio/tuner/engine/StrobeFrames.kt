@@ -0,0 +1,50 @@
+package software.blob.audio.tuner.engine
+
+// Matches the native strobe engine
+private const val HARMONICS = 4
+private const val DEFAULT_CAPACITY = 512
+
+/**
+ * Reusable buffer for strobe frames fetched from the [TunerInputEngine]
+ * Each frame holds the phase and amplitude of the first few harmonics of the input relative
+ * to the strobe reference. Each fetch continues from where the previous one left off.
+ * @param capacity Maximum number of frames per fetch
+ */
+class StrobeFrames(capacity: Int = DEFAULT_CAPACITY) {
+
+    /**
+     * Packed (phase, amplitude) pairs, [HARMONICS] per frame, oldest frame first
+     * Laid out to be uploaded to GL as is
+     */
+    val values = FloatArray(capacity * HARMONICS * 2)
+
+    // Sequence number of the next frame to fetch (array so native can update it)
+    internal val sequence = LongArray(1)
+
+    /**
+     * Number of frames from the last fetch
+     */
+    var size = 0
+        internal set
+
+    /**
+     * Number of harmonics in each frame
+     */
+    val harmonics get() = HARMONICS
+
+    /**
+     * Get the phase of a harmonic relative to the reference
+     * @param index Frame index
+     * @param harmonic Harmonic index (0 for the fundamental)
+     * @return Phase in radians (-pi to pi)
+     */
+    fun phase(index: Int, harmonic: Int) = values[(index * HARMONICS + harmonic) * 2]
+
+    /**
+     * Get the amplitude of a harmonic
+     * @param index Frame index
+     * @param harmonic Harmonic index (0 for the fundamental)
+     * @return Peak amplitude
+     */
+    fun amplitude(index: Int, harmonic: Int) = values[(index * HARMONICS + harmonic) * 2 + 1]
+}
@@ -21,10 +21,20 @@ class TunerInputEngine {
      * @param bufferSize Buffer size in seconds (should be under 1 second)
      * @param minAmplitude Minimum scan amplitude
      * @param maxFrequency Maximum scan frequency
+     * @param int16Input True to read 16-bit input instead of floats (cheaper on low-end devices)
      * @return True if set successfully, false if the engine is currently running
      */
-    fun setParameters(bufferSize: Float, minAmplitude: Float, maxFrequency: Float): Boolean
-        = setParameters(ptr, bufferSize, minAmplitude, maxFrequency)
+    fun setParameters(bufferSize: Float, minAmplitude: Float, maxFrequency: Float,
+                      int16Input: Boolean = false): Boolean
+        = setParameters(ptr, bufferSize, minAmplitude, maxFrequency, int16Input)
+
+    /**
+     * Set whether the pitch history is tracked every 2.5 ms instead of once per analysis
+     * This cannot be called while the engine is running
+     * @param tracking True for high-rate tracking (for vibrato and other fast pitch changes)
+     * @return True if set successfully, false if the engine is currently running
+     */
+    fun setTracking(tracking: Boolean): Boolean = setTracking(ptr, tracking)
 
     /**
      * Start the tuner input engine
@@ -54,16 +64,78 @@ class TunerInputEngine {
     }
 
     /**
-     * Query frequency from the engine
+     * Query the latest frequency from the engine's analysis thread
      * @return Frequency in hertz
      */
     fun queryFrequency(): Float = queryFrequency(ptr)
 
     /**
-     * Gets a copy of the current sample buffer
-     * @param buf Array to store samples
+     * Fetch every pitch result recorded since the previous fetch into the same history
+     * Results are produced at the analysis rate, so this is independent of how often it's called
+     * @param history History buffer to fill
+     * @return Number of results fetched
+     */
+    fun fetchHistory(history: PitchHistory): Int {
+        history.size = fetchHistory(ptr, history.sequence, history.times, history.values)
+        return history.size
+    }
+
+    /**
+     * Set the frequency the strobe tracks the input phase against (i.e. the target note at
+     * the current tuning standard)
+     * @param frequency Reference frequency in hertz, or 0 to stop the strobe
+     */
+    fun setStrobeReference(frequency: Float) = setStrobeReference(ptr, frequency)
+
+    /**
+     * Fetch every strobe frame produced since the previous fetch into the same buffer
+     * @param frames Frame buffer to fill
+     * @return Number of frames fetched
+     */
+    fun fetchStrobe(frames: StrobeFrames): Int {
+        frames.size = fetchStrobe(ptr, frames.sequence, frames.values)
+        return frames.size
+    }
+
+    /**
+     * Whether the input is loud enough to be analyzed
+     * While false, [queryFrequency] returns 0 without doing any work
+     */
+    val inputActive: Boolean get() = _active && isInputActive(ptr)
+
+    /**
+     * Number of hops analyzed since the engine was created
+     */
+    val analyzedHops: Long get() = getAnalyzedHops(ptr)
+
+    /**
+     * Number of hops skipped since the engine was created because the pitch held steady
+     */
+    val skippedHops: Long get() = getSkippedHops(ptr)
+
+    /**
+     * Fetch a low passed copy of the current sample buffer if there's been new input since
+     * this waveform was last fetched
+     * The filtered copy is built on demand and shared by every waveform asking for the same input
+     * @param waveform Waveform to fill (at least the buffer size, otherwise nothing is copied)
+     * @return True if the waveform was updated
+     */
+    fun getSampleBuffer(waveform: Waveform): Boolean {
+        val count = getSampleBuffer(ptr, waveform.sequence, waveform.samples)
+        if (count > 0)
+            waveform.size = count
+        return count > 0
+    }
+
+    /**
+     * Fetch a min/max envelope of the current sample buffer decimated to the envelope width
+     * if there's been new input since it was last fetched
+     * This is much cheaper than [getSampleBuffer] for drawing waveform overviews
+     * @param envelope Envelope to fill
+     * @return True if the envelope was updated
      */
-    fun getSampleBuffer(buf: FloatArray) = getSampleBuffer(ptr, buf)
+    fun getWaveformEnvelope(envelope: WaveformEnvelope): Boolean =
+        getWaveformEnvelope(ptr, envelope.sequence, envelope.min, envelope.max)
 
     companion object {
 
@@ -85,13 +157,25 @@ class TunerInputEngine {
          * @param bufferSize Buffer size in seconds (should be under 1 second)
          * @param minAmplitude Minimum scan amplitude
          * @param maxFrequency Maximum scan frequency
+         * @param int16Input True to read 16-bit input instead of floats
          * @return True if set successfully, false if the engine is currently running
          */
         @JvmStatic
         external fun setParameters(ptr: Long,
                                    bufferSize: Float,
                                    minAmplitude: Float,
-                                   maxFrequency: Float): Boolean
+                                   maxFrequency: Float,
+                                   int16Input: Boolean): Boolean
+
+        /**
+         * Set whether the native engine tracks the pitch history at a high rate
+         * This cannot be called while the engine is running
+         * @param ptr Engine pointer
+         * @param tracking True for high-rate tracking
+         * @return True if set successfully, false if the engine is currently running
+         */
+        @JvmStatic
+        external fun setTracking(ptr: Long, tracking: Boolean): Boolean
 
         /**
          * Start the native engine
@@ -132,11 +216,79 @@ class TunerInputEngine {
         external fun queryFrequency(ptr: Long): Float
 
         /**
-         * Gets a copy of the current sample buffer
+         * Copy pitch results from the native history ring
          * @param ptr Engine pointer
+         * @param sequence Sequence number of the first result wanted (updated to the next one)
+         * @param times Array to store the audio time of each result
+         * @param values Array to store (frequency, confidence) pairs
+         * @return Number of results copied
+         */
+        @JvmStatic
+        external fun fetchHistory(ptr: Long, sequence: LongArray, times: DoubleArray,
+                                  values: FloatArray): Int
+
+        /**
+         * Set the strobe reference frequency
+         * @param ptr Engine pointer
+         * @param frequency Reference frequency in hertz (0 to stop)
+         */
+        @JvmStatic
+        external fun setStrobeReference(ptr: Long, frequency: Float)
+
+        /**
+         * Fetch strobe frames produced since a sequence number
+         * @param ptr Engine pointer
+         * @param sequence Sequence number of the next frame (updated)
+         * @param out Packed (phase, amplitude) values per harmonic per frame
+         * @return Number of frames fetched
+         */
+        @JvmStatic
+        external fun fetchStrobe(ptr: Long, sequence: LongArray, out: FloatArray): Int
+
+        /**
+         * Check if the native engine's level gate is open
+         * @param ptr Engine pointer
+         * @return True if the input is loud enough to be analyzed
+         */
+        @JvmStatic
+        external fun isInputActive(ptr: Long): Boolean
+
+        /**
+         * Get the number of hops the native engine has analyzed
+         * @param ptr Engine pointer
+         * @return Number of analyses
+         */
+        @JvmStatic
+        external fun getAnalyzedHops(ptr: Long): Long
+
+        /**
+         * Get the number of hops the native engine skipped while the pitch held steady
+         * @param ptr Engine pointer
+         * @return Number of skipped hops
+         */
+        @JvmStatic
+        external fun getSkippedHops(ptr: Long): Long
+
+        /**
+         * Gets a low passed copy of the current sample buffer if there's new input
+         * @param ptr Engine pointer
+         * @param sequence Input sequence last seen (updated)
          * @param buf Array to store samples
+         * @return Number of samples copied (0 if nothing new)
+         */
+        @JvmStatic
+        external fun getSampleBuffer(ptr: Long, sequence: LongArray, buf: FloatArray): Int
+
+        /**
+         * Gets a min/max envelope of the current sample buffer if there's new input
+         * @param ptr Engine pointer
+         * @param sequence Input sequence last seen (updated)
+         * @param min Array to store the minimum of each column
+         * @param max Array to store the maximum of each column
+         * @return True if the envelope was filled
          */
         @JvmStatic
-        external fun getSampleBuffer(ptr: Long, buf: FloatArray)
+        external fun getWaveformEnvelope(ptr: Long, sequence: LongArray,
+                                         min: FloatArray, max: FloatArray): Boolean
     }
 }
\ No newline at end of file
@@ -0,0 +1,44 @@
+package software.blob.audio.tuner.engine
+
+/**
+ * Reusable buffer for low passed waveform snapshots fetched from the [TunerInputEngine]
+ * Each waveform remembers the input it last saw, so fetching again before new input
+ * arrives returns right away
+ * @param capacity Maximum number of samples (at least the engine's buffer size)
+ */
+class Waveform(capacity: Int) {
+
+    /**
+     * Samples from the last fetch, oldest first
+     */
+    val samples = FloatArray(capacity)
+
+    // Input sequence (total frames) of the last fetch (array so native can update it)
+    internal val sequence = LongArray(1)
+
+    /**
+     * Number of samples from the last fetch
+     */
+    var size = 0
+        internal set
+}
+
+/**
+ * Reusable min/max envelope of the raw input fetched from the [TunerInputEngine]
+ * @param width Number of columns (i.e. one per pixel)
+ */
+class WaveformEnvelope(width: Int) {
+
+    /**
+     * Minimum of each column
+     */
+    val min = FloatArray(width)
+
+    /**
+     * Maximum of each column
+     */
+    val max = FloatArray(width)
+
+    // Input sequence (total frames) of the last fetch (array so native can update it)
+    internal val sequence = LongArray(1)
+}
@@ -7,6 +7,7 @@ import android.view.View
 import android.view.ViewGroup
 import software.blob.audio.tuner.R
 import software.blob.audio.tuner.databinding.DualMeterFragmentBinding
+import software.blob.audio.tuner.engine.PitchHistory
 import software.blob.audio.tuner.view.GraphMeterView
 import software.blob.audio.tuner.view.RadialMeterPointerView
 
@@ -40,14 +41,22 @@ class DualMeterFragment : TunerFragment() {
     }
 
     /**
-     * Set the pointer facing the latest cent value and update the graph
+     * Set the pointer facing the latest cent value
      * @param latestNote Note value
      * @param avgNote Average note value
      * @param avgCents Average cents value
      */
     override fun addNoteSample(latestNote: Double, avgNote: Double, avgCents: Double) {
         radialMeter.cents = avgCents
-        binding.graphView.addSample(latestNote)
+    }
+
+    /**
+     * Add the latest pitch results to the graph
+     * @param history Latest results
+     * @param tuningStandard Frequency of A4 in hertz
+     */
+    override fun addHistory(history: PitchHistory, tuningStandard: Double) {
+        binding.graphView.addSamples(history, tuningStandard)
     }
 
     /**
@@ -5,6 +5,7 @@ import android.view.LayoutInflater
 import android.view.View
 import android.view.ViewGroup
 import software.blob.audio.tuner.databinding.GraphMeterFragmentBinding
+import software.blob.audio.tuner.engine.PitchHistory
 import software.blob.audio.tuner.view.GraphMeterView
 
 /**
@@ -34,12 +35,20 @@ class GraphMeterFragment : TunerFragment() {
     }
 
     /**
-     * Add the latest note sample to the view
-     * @param latestNote Latest note value
+     * The graph is drawn from the engine history instead
+     * @param latestNote Latest note value (unused here)
      * @param avgNote Average note value (unused here)
      * @param avgCents Cents value (unused here)
      */
     override fun addNoteSample(latestNote: Double, avgNote: Double, avgCents: Double) {
-        binding.graphView.addSample(latestNote)
+    }
+
+    /**
+     * Add the latest pitch results to the graph
+     * @param history Latest results
+     * @param tuningStandard Frequency of A4 in hertz
+     */
+    override fun addHistory(history: PitchHistory, tuningStandard: Double) {
+        binding.graphView.addSamples(history, tuningStandard)
     }
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 package software.blob.audio.tuner.fragment
 
+import android.app.ActivityManager
 import android.content.Context
 import android.media.AudioDeviceInfo
 import android.media.AudioManager
@@ -16,6 +17,7 @@ import com.google.android.material.snackbar.Snackbar
 import software.blob.android.collections.FIFOList
 import software.blob.android.thread.BasicIntervalThread
 import software.blob.audio.tuner.R
+import software.blob.audio.tuner.engine.PitchHistory
 import software.blob.audio.tuner.engine.TunerInputEngine
 import software.blob.audio.tuner.preference.TunerPreferences
 import software.blob.audio.tuner.view.NoteTextLayout
@@ -42,6 +44,9 @@ private const val READINGS_TIMEOUT = 1000
 // The amount of time before the display is reset (ms)
 private const val DISPLAY_TIMEOUT = 5000
 
+// The amount of time to wait between queries while the input is silent (ms)
+private const val IDLE_INTERVAL = 100L
+
 /**
  * Base fragment class for views driven by the [TunerInputEngine]
  */
@@ -58,6 +63,9 @@ abstract class TunerFragment : Fragment() {
     // Window of latest frequency readings that are averaged together for smoother results
     private val readings = FIFOList<Double>(READINGS_CAPACITY)
 
+    // Pitch results fetched from the engine on each tick
+    private val history = PitchHistory()
+
     /**
      * Initialize the components for this fragment
      * Sub-classes should call the super for this method while providing their inflated view
@@ -110,6 +118,15 @@ abstract class TunerFragment : Fragment() {
      */
     abstract fun addNoteSample(latestNote: Double, avgNote: Double, avgCents: Double)
 
+    /**
+     * Add the pitch results the engine has analyzed since the last call
+     * This is called from the [BasicIntervalThread] that pulls samples from the engine
+     * @param history Latest results
+     * @param tuningStandard Frequency of A4 in hertz
+     */
+    open fun addHistory(history: PitchHistory, tuningStandard: Double) {
+    }
+
     /**
      * Update the views which displays the current note (called on UI Thread)
      * @param noteName The note name (scientific notation)
@@ -150,9 +167,11 @@ abstract class TunerFragment : Fragment() {
         }
 
         // Set the filtering parameters for the input engine
+        // Low-end devices read 16-bit input to avoid format conversion and halve buffer traffic
         val minAmp = getAmplitude(prefs.minInputVolume.toDouble()).toFloat()
         val tuningStandard = prefs.tuningStandard.toDouble()
-        if (!engine.setParameters(0.2f, minAmp, prefs.maxInputFrequency)) {
+        val activityManager = requireContext().getSystemService(Context.ACTIVITY_SERVICE) as ActivityManager
+        if (!engine.setParameters(0.2f, minAmp, prefs.maxInputFrequency, activityManager.isLowRamDevice)) {
             showError(R.string.failed_to_setup_microphone)
             Log.e(TAG, "Failed to set parameters on engine")
             return
@@ -172,6 +191,10 @@ abstract class TunerFragment : Fragment() {
         var lastNonZero = System.currentTimeMillis()
         val thread = BasicIntervalThread(FPS) {
 
+            // Pull everything analyzed since the last tick for views that draw history
+            if (engine.fetchHistory(history) > 0)
+                addHistory(history, tuningStandard)
+
             // Pull a frequency sample from the engine
             val freq = engine.queryFrequency().toDouble()
 
@@ -202,6 +225,9 @@ abstract class TunerFragment : Fragment() {
                 // Clear text if there's no input after 5 seconds
                 if (silenceTime >= DISPLAY_TIMEOUT) runOnUiThread { reset() }
 
+                // Nothing to analyze while the engine's input gate is closed, so query less often
+                if (!engine.inputActive) Thread.sleep(IDLE_INTERVAL)
+
                 return@BasicIntervalThread
             }
 
@@ -13,6 +13,7 @@ import software.blob.audio.tuner.R
 import software.blob.android.opengl.drawable.GLRectangle
 import software.blob.audio.tuner.data.NoteCurve
 import software.blob.audio.tuner.data.NoteSample
+import software.blob.audio.tuner.engine.PitchHistory
 import software.blob.android.opengl.layer.GLBasic2DLayer
 import software.blob.android.opengl.layer.GLCachedTextLayer
 import software.blob.android.opengl.layer.GLLayer
@@ -21,6 +22,7 @@ import software.blob.audio.tuner.gl.drawable.GLNoteCurve
 import software.blob.android.opengl.shader.GLBasicShader
 import software.blob.audio.tuner.preference.TunerPreferences
 import software.blob.audio.tuner.util.getNoteName
+import software.blob.audio.tuner.util.getNoteValue
 import javax.microedition.khronos.egl.EGL10
 import javax.microedition.khronos.egl.EGL10.*
 import javax.microedition.khronos.egl.EGLConfig
@@ -31,6 +33,9 @@ import kotlin.math.*
 private const val TAG = "GraphMeterView"
 private const val NOTE_WIDTH = 0.25
 
+// Maximum difference between the engine's audio clock and the view clock before re-syncing (s)
+private const val MAX_CLOCK_DRIFT = 0.5
+
 /**
  * Tuner view that shows pitch values on a graph
  */
@@ -42,6 +47,7 @@ class GraphMeterView @JvmOverloads constructor(context: Context, attrs: Attribut
 
     private val prefs = TunerPreferences(context)
     private var startMillis = System.currentTimeMillis()
+    private var audioTimeOffset = Double.NaN
     private val density = resources.displayMetrics.density
 
     /**
@@ -140,13 +146,28 @@ class GraphMeterView @JvmOverloads constructor(context: Context, attrs: Attribut
     }
 
     /**
-     * Add a note sample to the tuner view
-     * @param note Note value
+     * Add pitch results from the engine history to the tuner view
+     * Samples keep their audio timestamps so the curve doesn't depend on the caller's frame rate
+     * @param history Pitch results
+     * @param tuningStandard Frequency of A4 in hertz
      */
-    fun addSample(note: Double) {
-        if (note <= 0 || note.isNaN()) return
-        val sample = NoteSample(curTimeDelta(), note)
-        queueEvent { addSample(sample) }
+    fun addSamples(history: PitchHistory, tuningStandard: Double) {
+        if (history.size == 0) return
+
+        // Map audio time onto the view clock, re-syncing when the engine restarts or drifts
+        val now = curTimeDelta()
+        val newest = history.time(history.size - 1)
+        if (audioTimeOffset.isNaN() || abs(newest + audioTimeOffset - now) > MAX_CLOCK_DRIFT)
+            audioTimeOffset = now - newest
+
+        val samples = ArrayList<NoteSample>(history.size)
+        for (i in 0 until history.size) {
+            val note = getNoteValue(history.frequency(i), tuningStandard)
+            if (note > 0 && !note.isNaN())
+                samples += NoteSample(history.time(i) + audioTimeOffset, note)
+        }
+        if (samples.isNotEmpty())
+            queueEvent { for (sample in samples) addSample(sample) }
     }
 
     /**
@@ -350,12 +371,11 @@ class GraphMeterView @JvmOverloads constructor(context: Context, attrs: Attribut
         var minNote = sample.note
         var maxNote = sample.note
         var curve: GLNoteCurve? = null
-        val curTime = curTimeDelta()
         for (o in curveLayer) {
             val c = o as GLNoteCurve
             val cLast = c.last()
             if (cLast != null) {
-                if (curve == null && (curTime - cLast.time) <= timeThresh &&
+                if (curve == null && (sample.time - cLast.time) <= timeThresh &&
                     cLast.note - sample.note < noteThresh)
                     curve = c
                 minNote = min(minNote, cLast.note)